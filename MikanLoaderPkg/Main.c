@@ -9,6 +9,7 @@
 #include  <Protocol/DiskIo2.h>
 #include  <Protocol/BlockIo.h>
 #include  <Guid/FileInfo.h>
+#include  <Guid/Acpi.h>
 
 #include "frame_buffer_config.hpp"
 #include "memory_map.hpp"
@@ -350,6 +351,17 @@ EFI_STATUS EFIAPI UefiMain(EFI_HANDLE image_handle, EFI_SYSTEM_TABLE *system_tab
     }
     // #@@ range_begin(pass_frame_buffer_config)
 
+    // #@@ range_begin(find_acpi_table)
+    VOID* acpi_table = NULL;
+    for (UINTN i = 0; i < system_table->NumberOfTableEntries; ++i) {
+        if (CompareGuid(&gEfiAcpiTableGuid,
+                        &system_table->ConfigurationTable[i].VendorGuid)) {
+            acpi_table = system_table->ConfigurationTable[i].VendorTable;
+            break;
+        }
+    }
+    // #@@ range_end(find_acpi_table)
+
     // #@@ range_begin(exit_bs)
     status = gBS->ExitBootServices(image_handle, memmap.map_key);
     
@@ -370,9 +382,11 @@ EFI_STATUS EFIAPI UefiMain(EFI_HANDLE image_handle, EFI_SYSTEM_TABLE *system_tab
     // #@@ range_begin(call_kernel)
     UINT64 entry_addr = *(UINT64*)(kernel_first_addr + 24);
 
-    typedef void EntryPointType(const struct FrameBufferConfig*, const struct MemoryMap*);
+    typedef void EntryPointType(const struct FrameBufferConfig*,
+                                const struct MemoryMap*,
+                                const VOID*);
     EntryPointType* entry_point = (EntryPointType*)entry_addr;
-    entry_point(&fb_config, &memmap);
+    entry_point(&fb_config, &memmap, acpi_table);
     // #@@ range_end(call_kernel)
 
     Halt();
@@ -0,0 +1,108 @@
+#include "acpi.hpp"
+
+#include <cstring>
+
+#include "asmfunc.h"
+#include "logger.hpp"
+
+namespace {
+    template <typename T>
+    uint8_t SumBytes(const T* data, size_t bytes) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        uint8_t sum = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            sum += p[i];
+        }
+        return sum;
+    }
+}
+
+namespace acpi {
+    bool RSDP::IsValid() const {
+        if (strncmp(signature, "RSD PTR ", 8) != 0) {
+            Log(kDebug, "invalid RSDP signature: %.8s\n", signature);
+            return false;
+        }
+        if (revision != 2) {
+            Log(kDebug, "ACPI revision must be 2: %d\n", revision);
+            return false;
+        }
+        if (auto sum = SumBytes(this, 20); sum != 0) {
+            Log(kDebug, "sum of 20 bytes must be 0: %d\n", sum);
+            return false;
+        }
+        if (auto sum = SumBytes(this, 36); sum != 0) {
+            Log(kDebug, "sum of 36 bytes must be 0: %d\n", sum);
+            return false;
+        }
+        return true;
+    }
+
+    bool DescriptionHeader::IsValid(const char* expected_signature) const {
+        if (strncmp(signature, expected_signature, 4) != 0) {
+            Log(kDebug, "invalid signature: %.4s\n", signature);
+            return false;
+        }
+        if (auto sum = SumBytes(this, length); sum != 0) {
+            Log(kDebug, "sum of %u bytes must be 0: %d\n", length, sum);
+            return false;
+        }
+        return true;
+    }
+
+    const DescriptionHeader& XSDT::operator[](size_t i) const {
+        // 헤더 뒤의 64비트 주소 배열은 8바이트 정렬이 아닐 수 있다
+        uint64_t address;
+        memcpy(&address, reinterpret_cast<const uint8_t*>(&header + 1) + sizeof(uint64_t) * i,
+               sizeof(address));
+        return *reinterpret_cast<const DescriptionHeader*>(address);
+    }
+
+    size_t XSDT::Count() const {
+        return (header.length - sizeof(DescriptionHeader)) / sizeof(uint64_t);
+    }
+
+    const FADT* fadt;
+
+    void WaitMilliseconds(unsigned long msec) {
+        const bool pm_timer_32 = (fadt->flags >> 8) & 1;
+        const uint32_t start = IoIn32(fadt->pm_tmr_blk);
+        uint32_t end = start + kPMTimerFreq * msec / 1000;
+        if (!pm_timer_32) {
+            end &= 0x00ffffffu;
+        }
+
+        if (end < start) {  // 카운터가 한 바퀴 돈다
+            while (IoIn32(fadt->pm_tmr_blk) >= start);
+        }
+        while (IoIn32(fadt->pm_tmr_blk) < end);
+    }
+
+    void Initialize(const RSDP* rsdp) {
+        if (rsdp == nullptr || !rsdp->IsValid()) {
+            Log(kWarn, "RSDP is not available\n");
+            return;
+        }
+
+        const XSDT& xsdt = *reinterpret_cast<const XSDT*>(rsdp->xsdt_address);
+        if (!xsdt.header.IsValid("XSDT")) {
+            Log(kWarn, "XSDT is not valid\n");
+            return;
+        }
+
+        for (size_t i = 0; i < xsdt.Count(); ++i) {
+            const auto& entry = xsdt[i];
+            if (entry.IsValid("FACP")) {
+                fadt = reinterpret_cast<const FADT*>(&entry);
+                break;
+            }
+        }
+
+        if (fadt == nullptr) {
+            Log(kWarn, "FADT is not found\n");
+            return;
+        }
+        Log(kInfo, "ACPI PM timer at port 0x%x (%d bits)\n",
+            fadt->pm_tmr_blk, (fadt->flags >> 8) & 1 ? 32 : 24);
+    }
+}
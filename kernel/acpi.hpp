@@ -0,0 +1,80 @@
+/**
+ * @file acpi.hpp
+ *
+ * ACPI 테이블을 읽는 기능. 부트로더가 넘겨준 RSDP에서 XSDT를 거쳐 FADT를 찾고,
+ * FADT에 적힌 ACPI PM 타이머로 정확한 시간 대기를 제공한다.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace acpi {
+    /** @brief Root System Description Pointer. UEFI 설정 테이블에서 얻는다 */
+    struct RSDP {
+        char signature[8];
+        uint8_t checksum;
+        char oem_id[6];
+        uint8_t revision;
+        uint32_t rsdt_address;
+        uint32_t length;
+        uint64_t xsdt_address;
+        uint8_t extended_checksum;
+        char reserved[3];
+
+        /** @brief 서명, 체크섬, 리비전(ACPI 2.0 이상)이 올바른지 검사합니다. */
+        bool IsValid() const;
+    } __attribute__((packed));
+
+    /** @brief 모든 시스템 기술 테이블(SDT) 앞에 붙는 공통 헤더 */
+    struct DescriptionHeader {
+        char signature[4];
+        uint32_t length;
+        uint8_t revision;
+        uint8_t checksum;
+        char oem_id[6];
+        char oem_table_id[8];
+        uint32_t oem_revision;
+        uint32_t creator_id;
+        uint32_t creator_revision;
+
+        /** @brief 서명이 expected_signature와 같고 체크섬이 올바른지 검사합니다. */
+        bool IsValid(const char* expected_signature) const;
+    } __attribute__((packed));
+
+    /** @brief Extended System Description Table. 다른 SDT의 주소 목록 */
+    struct XSDT {
+        DescriptionHeader header;
+
+        /** @brief 목록의 i번째 SDT */
+        const DescriptionHeader& operator[](size_t i) const;
+        /** @brief 목록의 SDT 수 */
+        size_t Count() const;
+    } __attribute__((packed));
+
+    /** @brief Fixed ACPI Description Table. PM 타이머 관련 필드까지만 정의한다 */
+    struct FADT {
+        DescriptionHeader header;
+
+        char reserved1[76 - sizeof(header)];
+        /** @brief PM 타이머 I/O 포트 */
+        uint32_t pm_tmr_blk;
+        char reserved2[112 - 80];
+        /** @brief 비트 8(TMR_VAL_EXT)이 1이면 PM 타이머가 32비트, 0이면 24비트 */
+        uint32_t flags;
+        char reserved3[276 - 116];
+    } __attribute__((packed));
+
+    /** @brief ACPI PM 타이머의 주파수(Hz) */
+    const uint32_t kPMTimerFreq = 3579545;
+
+    /** @brief Initialize로 찾은 FADT. 찾지 못했으면 nullptr */
+    extern const FADT* fadt;
+
+    /** @brief PM 타이머로 msec 밀리초 동안 바쁜 대기를 합니다. fadt가 있어야 합니다. */
+    void WaitMilliseconds(unsigned long msec);
+
+    /** @brief RSDP에서 FADT를 찾습니다. rsdp가 nullptr이거나 테이블이 올바르지 않으면 fadt는 nullptr로 남습니다. */
+    void Initialize(const RSDP* rsdp);
+}
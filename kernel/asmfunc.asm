@@ -19,6 +19,20 @@ IoIn32:
     in eax, dx
     ret
 
+global IoOut8  ; void IoOut8(uint16_t addr, uint8_t data);
+IoOut8:
+    mov dx, di    ; dx = addr
+    mov al, sil   ; al = data
+    out dx, al
+    ret
+
+global IoIn8  ; uint8_t IoIn8(uint16_t addr);
+IoIn8:
+    mov dx, di    ; dx = addr
+    xor eax, eax
+    in al, dx
+    ret
+
 global GetCS  ; uint16_t GetCS(void);
 GetCS:
     xor eax, eax  ; also clears upper 32 bits of rax
@@ -76,6 +90,42 @@ SetCR3:
     mov cr3, rdi
     ret
 
+global GetCR0  ; uint64_t GetCR0(void);
+GetCR0:
+    mov rax, cr0
+    ret
+
+global SetCR0  ; void SetCR0(uint64_t value);
+SetCR0:
+    mov cr0, rdi
+    ret
+
+global GetCR2  ; uint64_t GetCR2(void);
+GetCR2:
+    mov rax, cr2
+    ret
+
+global InvalidateTLB  ; void InvalidateTLB(uint64_t addr);
+InvalidateTLB:
+    invlpg [rdi]
+    ret
+
+global ReadTSC  ; uint64_t ReadTSC(void);
+ReadTSC:
+    rdtsc         ; edx:eax = time stamp counter
+    shl rdx, 32
+    or rax, rdx
+    ret
+
+global WriteMSR  ; void WriteMSR(uint32_t msr, uint64_t value);
+WriteMSR:
+    mov rdx, rsi
+    shr rdx, 32
+    mov eax, esi
+    mov ecx, edi
+    wrmsr         ; msr[ecx] = edx:eax
+    ret
+
 extern kernel_main_stack
 extern KernelMainNewStack
 
@@ -0,0 +1,122 @@
+#include "clocksource.hpp"
+
+#include <cpuid.h>
+
+#include "asmfunc.h"
+#include "logger.hpp"
+#include "timer.hpp"
+
+namespace {
+    const uint64_t kNsPerSecond = 1'000'000'000;
+    /** @brief ns = (cycles * mult) >> kMultShift */
+    const int kMultShift = 32;
+
+    bool invariant_tsc;
+    uint64_t tsc_base;
+    uint64_t mult;
+    /** @brief NowNs가 0일 때의 실제 시각(1970년부터의 나노초) */
+    uint64_t realtime_base_ns;
+
+    bool HasInvariantTSC() {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return edx & (1u << 8);
+    }
+
+    const uint16_t kCMOSAddress = 0x70;
+    const uint16_t kCMOSData = 0x71;
+
+    uint8_t ReadCMOS(uint8_t reg) {
+        IoOut8(kCMOSAddress, reg);
+        return IoIn8(kCMOSData);
+    }
+
+    struct RTCTime {
+        unsigned int second, minute, hour, day, month, year;
+
+        bool operator==(const RTCTime& rhs) const {
+            return second == rhs.second && minute == rhs.minute && hour == rhs.hour &&
+                day == rhs.day && month == rhs.month && year == rhs.year;
+        }
+    };
+
+    RTCTime ReadRTCOnce() {
+        while (ReadCMOS(0x0a) & 0x80);  // 갱신 중이면 기다린다
+        return RTCTime{ReadCMOS(0x00), ReadCMOS(0x02), ReadCMOS(0x04),
+                       ReadCMOS(0x07), ReadCMOS(0x08), ReadCMOS(0x09)};
+    }
+
+    unsigned int FromBCD(unsigned int v) {
+        return (v & 0x0f) + (v >> 4) * 10;
+    }
+
+    /** @brief RTC를 읽어 1970년부터의 초로 반환합니다. RTC는 UTC라고 가정한다 */
+    uint64_t ReadRTCSeconds() {
+        RTCTime t = ReadRTCOnce(), prev;
+        do {
+            prev = t;
+            t = ReadRTCOnce();
+        } while (!(t == prev));
+
+        const uint8_t status_b = ReadCMOS(0x0b);
+        const bool pm = t.hour & 0x80;
+        t.hour &= 0x7f;
+        if ((status_b & 0x04) == 0) {   // BCD
+            t.second = FromBCD(t.second);
+            t.minute = FromBCD(t.minute);
+            t.hour = FromBCD(t.hour);
+            t.day = FromBCD(t.day);
+            t.month = FromBCD(t.month);
+            t.year = FromBCD(t.year);
+        }
+        if ((status_b & 0x02) == 0) {   // 12시간제
+            t.hour = t.hour % 12 + (pm ? 12 : 0);
+        }
+        t.year += 2000;
+
+        // 그레고리력 날짜를 1970-01-01부터의 일수로 바꾼다(3월을 한 해의 시작으로 본다)
+        const int y = t.year - (t.month <= 2);
+        const int era = y / 400;
+        const unsigned int yoe = y - era * 400;
+        const unsigned int doy = (153 * (t.month + (t.month > 2 ? -3 : 9)) + 2) / 5 + t.day - 1;
+        const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        const int64_t days = static_cast<int64_t>(era) * 146097 + doe - 719468;
+
+        return days * 86400 + t.hour * 3600 + t.minute * 60 + t.second;
+    }
+}
+
+extern "C" uint64_t NowNs(void) {
+    if (invariant_tsc) {
+        const uint64_t cycles = ReadTSC() - tsc_base;
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * mult) >> kMultShift);
+    }
+    if (timer_manager == nullptr) {
+        return 0;
+    }
+    return timer_manager->CurrentTick() * (kNsPerSecond / kTimerFreq);
+}
+
+extern "C" uint64_t RealtimeNs(void) {
+    return realtime_base_ns + NowNs();
+}
+
+bool ClockSourceIsInvariantTSC() {
+    return invariant_tsc;
+}
+
+void InitializeClockSource() {
+    if (HasInvariantTSC() && tsc_freq != 0) {
+        mult = (kNsPerSecond << kMultShift) / tsc_freq;
+        tsc_base = ReadTSC();
+        invariant_tsc = true;
+    } else {
+        Log(kWarn, "TSC is not invariant, falling back to timer ticks\n");
+    }
+
+    realtime_base_ns = ReadRTCSeconds() * kNsPerSecond - NowNs();
+    Log(kInfo, "clock source: %s, realtime %lu s\n",
+        invariant_tsc ? "invariant TSC" : "timer tick", realtime_base_ns / kNsPerSecond);
+}
@@ -0,0 +1,26 @@
+/**
+ * @file clocksource.hpp
+ *
+ * 인터럽트 없이 읽을 수 있는 나노초 단위의 단조 증가 시계.
+ * 불변(invariant) TSC가 있으면 TSC를 곱셈과 시프트만으로 나노초로 바꾸고,
+ * 없으면 타이머 틱으로 대신한다. newlib_support.c의 clock_gettime, gettimeofday가 이 함수들을 호출한다.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+extern "C" {
+    /** @brief InitializeClockSource 이후 경과한 나노초. 초기화 전에는 0 */
+    uint64_t NowNs(void);
+    /** @brief 1970-01-01 00:00:00 UTC부터의 나노초. 부팅 시 RTC에서 읽은 시각에 NowNs를 더한다 */
+    uint64_t RealtimeNs(void);
+}
+
+/** @brief NowNs가 불변 TSC를 쓰는지 여부. false면 타이머 틱 해상도이다 */
+bool ClockSourceIsInvariantTSC();
+
+/** @brief 불변 TSC를 확인하고 변환 계수를 구한 뒤 RTC에서 현재 시각을 읽습니다.
+ * InitializeLAPICTimer가 tsc_freq를 보정한 뒤에 호출해야 합니다.
+ */
+void InitializeClockSource();
@@ -1,14 +1,18 @@
 #include "console.hpp"
 
 #include <cstring>
+#include <algorithm>
 
 #include "font.hpp"
 #include "layer.hpp"
 #include "graphics.hpp"
+#include "logger.hpp"
+#include "log_ring.hpp"
 
 Console::Console(const PixelColor &fg_color, const PixelColor &bg_color)
     : writer_{nullptr}, window_{}, fg_color_{fg_color}, bg_color_{bg_color},
-      buffer_{}, cursor_row_{0}, cursor_column_{0}, layer_id_{0} {}
+      buffer_{}, cursor_row_{0}, cursor_column_{0}, layer_id_{0},
+      dirty_begin_row_{kRows}, dirty_end_row_{0} {}
 
 void Console::PutString(const char *s) {
     while (*s) {
@@ -19,13 +23,28 @@ void Console::PutString(const char *s) {
                        Vector2D<int>{8 * cursor_column_, 16 * cursor_row_}, *s,
                        fg_color_);
             buffer_[cursor_row_][cursor_column_] = *s;
+            MarkDirty(cursor_row_, cursor_row_ + 1);
             ++cursor_column_;
         }
         ++s;
     }
-    if (layer_manager) {
-        layer_manager->Draw(layer_id_);
+}
+
+void Console::Flush() {
+    if (dirty_begin_row_ >= dirty_end_row_) {
+        return;
     }
+    if (window_ && layer_manager) {
+        layer_manager->Draw(layer_id_, {{0, 16 * dirty_begin_row_},
+                                        {8 * kColumns, 16 * (dirty_end_row_ - dirty_begin_row_)}});
+    }
+    dirty_begin_row_ = kRows;
+    dirty_end_row_ = 0;
+}
+
+void Console::MarkDirty(int begin_row, int end_row) {
+    dirty_begin_row_ = std::min(dirty_begin_row_, begin_row);
+    dirty_end_row_ = std::max(dirty_end_row_, end_row);
 }
 
 void Console::SetLayerID(unsigned int layer_id) {
@@ -66,6 +85,7 @@ void Console::Newline() {
         window_->Move({0, 0}, move_src);
         FillRectangle(*writer_, {0, 16 * (kRows - 1)}, {8 * kColumns, 16},
                       bg_color_);
+        MarkDirty(0, kRows);
     } else {
         FillRectangle(*writer_, {0, 0}, {8 * kColumns, 16 * kRows}, bg_color_);
         for (int row = 0; row < kRows - 1; ++row) {
@@ -83,12 +103,27 @@ void Console::Refresh() {
         WriteString(*writer_, Vector2D<int>{0, 16 * row}, buffer_[row],
                     fg_color_);
     }
+    MarkDirty(0, kRows);
 }
 
 Console* console;
 
 namespace {
     char console_buf[sizeof(Console)];
+
+    /** @brief 로그 레코드를 콘솔에 출력하는 로그 싱크 */
+    class ConsoleLogSink : public LogSink {
+    public:
+        void Write(const LogRecord& record) override {
+            console->PutString(record.text);
+        }
+
+        void Flush() override {
+            console->Flush();
+        }
+    };
+
+    char console_log_sink_buf[sizeof(ConsoleLogSink)];
 }
 
 void InitializeConsole() {
@@ -96,4 +131,5 @@ void InitializeConsole() {
             kDesktopFGColor, kDesktopBGColor
     };
     console->SetWriter(screen_writer);
+    AddLogSink(new(console_log_sink_buf) ConsoleLogSink);
 }
\ No newline at end of file
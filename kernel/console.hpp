@@ -9,7 +9,10 @@ public:
     static const int kRows = 25, kColumns = 80;
 
     Console(const PixelColor &fg_color, const PixelColor &bg_color);
+    /** @brief 문자열을 콘솔 버퍼에 씁니다. 화면 반영은 Flush 호출 시점까지 미뤄집니다. */
     void PutString(const char *s);
+    /** @brief 마지막 Flush 이후 변경된 행들을 하나의 사각형으로 묶어 화면에 반영합니다. */
+    void Flush();
     void SetWriter(PixelWriter *writer);
     void SetWindow(const std::shared_ptr<Window> &window);
     void SetLayerID(unsigned int layer_id);
@@ -18,6 +21,8 @@ public:
 private:
     void Newline();
     void Refresh();
+    /** @brief [begin_row, end_row) 범위의 행을 다음 Flush 대상에 포함시킵니다. */
+    void MarkDirty(int begin_row, int end_row);
 
     PixelWriter *writer_;
     std::shared_ptr<Window> window_;
@@ -25,6 +30,8 @@ private:
     char buffer_[kRows][kColumns + 1];
     int cursor_row_, cursor_column_;
     int layer_id_;
+    /** @brief 아직 화면에 반영되지 않은 행 범위 [dirty_begin_row_, dirty_end_row_) */
+    int dirty_begin_row_, dirty_end_row_;
 };
 
 extern Console* console;
@@ -0,0 +1,289 @@
+#include "format.hpp"
+
+#include <cstdint>
+
+namespace {
+    struct Spec {
+        bool left{false}, zero{false}, plus{false}, space{false}, alt{false};
+        int width{0};
+        int precision{-1};
+    };
+
+    enum class Length {
+        kInt, kChar, kShort, kLong, kLongLong, kSize, kMax, kPtrDiff,
+    };
+
+    /** @brief sink에 출력하면서 글자 수를 세는 도우미 */
+    class Output {
+    public:
+        explicit Output(FormatSink& sink) : sink_{sink}, count_{0} {}
+
+        void Put(char c) {
+            sink_.Put(c);
+            ++count_;
+        }
+
+        void Write(const char* s, int len) {
+            sink_.Write(s, len);
+            count_ += len;
+        }
+
+        void Repeat(char c, int n) {
+            for (; n > 0; --n) {
+                Put(c);
+            }
+        }
+
+        int Count() const { return count_; }
+
+    private:
+        FormatSink& sink_;
+        int count_;
+    };
+
+    void FormatString(Output& out, const char* s, const Spec& spec) {
+        if (s == nullptr) {
+            s = "(null)";
+        }
+        int len = 0;
+        while (s[len] && (spec.precision < 0 || len < spec.precision)) {
+            ++len;
+        }
+
+        if (!spec.left) {
+            out.Repeat(' ', spec.width - len);
+        }
+        out.Write(s, len);
+        if (spec.left) {
+            out.Repeat(' ', spec.width - len);
+        }
+    }
+
+    void FormatInteger(Output& out, uint64_t value, bool negative,
+                       unsigned int base, bool upper, const Spec& spec) {
+        const char* digit_chars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+        char digits[24];
+        int num_digits = 0;
+        const bool is_zero = value == 0;
+        while (value > 0) {
+            digits[num_digits++] = digit_chars[value % base];
+            value /= base;
+        }
+        if (num_digits == 0 && spec.precision != 0) {
+            digits[num_digits++] = '0';
+        }
+
+        char prefix[2];
+        int prefix_len = 0;
+        if (negative) {
+            prefix[prefix_len++] = '-';
+        } else if (spec.plus) {
+            prefix[prefix_len++] = '+';
+        } else if (spec.space) {
+            prefix[prefix_len++] = ' ';
+        }
+        if (spec.alt && base == 16 && !is_zero) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = upper ? 'X' : 'x';
+        }
+
+        int num_zeros = spec.precision > num_digits ? spec.precision - num_digits : 0;
+        // 대체 형식의 8진수는 첫 자리가 0이 되도록 한다. %#.0o에 0을 주면 자릿수가 없으므로 "0" 하나를 출력한다
+        if (spec.alt && base == 8 && num_zeros == 0 &&
+            (num_digits == 0 || digits[num_digits - 1] != '0')) {
+            num_zeros = 1;
+        }
+        const int body_len = prefix_len + num_zeros + num_digits;
+        const int pad = spec.width - body_len;
+
+        if (!spec.left && !(spec.zero && spec.precision < 0)) {
+            out.Repeat(' ', pad);
+        }
+        out.Write(prefix, prefix_len);
+        if (!spec.left && spec.zero && spec.precision < 0) {
+            out.Repeat('0', pad);
+        }
+        out.Repeat('0', num_zeros);
+        for (int i = num_digits - 1; i >= 0; --i) {
+            out.Put(digits[i]);
+        }
+        if (spec.left) {
+            out.Repeat(' ', pad);
+        }
+    }
+
+    int64_t ReadSigned(va_list& ap, Length length) {
+        switch (length) {
+            case Length::kChar: return static_cast<signed char>(va_arg(ap, int));
+            case Length::kShort: return static_cast<short>(va_arg(ap, int));
+            case Length::kLong: return va_arg(ap, long);
+            case Length::kLongLong: return va_arg(ap, long long);
+            case Length::kSize: return va_arg(ap, ptrdiff_t);
+            case Length::kMax: return va_arg(ap, intmax_t);
+            case Length::kPtrDiff: return va_arg(ap, ptrdiff_t);
+            default: return va_arg(ap, int);
+        }
+    }
+
+    uint64_t ReadUnsigned(va_list& ap, Length length) {
+        switch (length) {
+            case Length::kChar: return static_cast<unsigned char>(va_arg(ap, unsigned int));
+            case Length::kShort: return static_cast<unsigned short>(va_arg(ap, unsigned int));
+            case Length::kLong: return va_arg(ap, unsigned long);
+            case Length::kLongLong: return va_arg(ap, unsigned long long);
+            case Length::kSize: return va_arg(ap, size_t);
+            case Length::kMax: return va_arg(ap, uintmax_t);
+            case Length::kPtrDiff: return va_arg(ap, size_t);
+            default: return va_arg(ap, unsigned int);
+        }
+    }
+}
+
+int VFormat(FormatSink& sink, const char* format, va_list ap_arg) {
+    Output out{sink};
+    va_list ap;
+    va_copy(ap, ap_arg);
+
+    const char* p = format;
+    while (*p) {
+        if (*p != '%') {
+            const char* literal = p;
+            while (*p && *p != '%') {
+                ++p;
+            }
+            out.Write(literal, p - literal);
+            continue;
+        }
+
+        const char* conversion_start = p++;
+        Spec spec;
+        for (bool flag = true; flag; ) {
+            switch (*p) {
+                case '-': spec.left = true; ++p; break;
+                case '0': spec.zero = true; ++p; break;
+                case '+': spec.plus = true; ++p; break;
+                case ' ': spec.space = true; ++p; break;
+                case '#': spec.alt = true; ++p; break;
+                default: flag = false;
+            }
+        }
+
+        if (*p == '*') {
+            spec.width = va_arg(ap, int);
+            if (spec.width < 0) {
+                spec.left = true;
+                spec.width = -spec.width;
+            }
+            ++p;
+        } else {
+            while ('0' <= *p && *p <= '9') {
+                spec.width = spec.width * 10 + (*p++ - '0');
+            }
+        }
+
+        if (*p == '.') {
+            ++p;
+            spec.precision = 0;
+            if (*p == '*') {
+                spec.precision = va_arg(ap, int);
+                ++p;
+            } else {
+                while ('0' <= *p && *p <= '9') {
+                    spec.precision = spec.precision * 10 + (*p++ - '0');
+                }
+            }
+        }
+
+        Length length = Length::kInt;
+        switch (*p) {
+            case 'h':
+                ++p;
+                length = Length::kShort;
+                if (*p == 'h') {
+                    ++p;
+                    length = Length::kChar;
+                }
+                break;
+            case 'l':
+                ++p;
+                length = Length::kLong;
+                if (*p == 'l') {
+                    ++p;
+                    length = Length::kLongLong;
+                }
+                break;
+            case 'z': ++p; length = Length::kSize; break;
+            case 'j': ++p; length = Length::kMax; break;
+            case 't': ++p; length = Length::kPtrDiff; break;
+        }
+
+        switch (*p) {
+            case 'd':
+            case 'i': {
+                const int64_t value = ReadSigned(ap, length);
+                const uint64_t magnitude =
+                    value < 0 ? ~static_cast<uint64_t>(value) + 1 : value;
+                FormatInteger(out, magnitude, value < 0, 10, false, spec);
+                break;
+            }
+            case 'u':
+                FormatInteger(out, ReadUnsigned(ap, length), false, 10, false, spec);
+                break;
+            case 'o':
+                FormatInteger(out, ReadUnsigned(ap, length), false, 8, false, spec);
+                break;
+            case 'x':
+            case 'X':
+                FormatInteger(out, ReadUnsigned(ap, length), false, 16, *p == 'X', spec);
+                break;
+            case 'p':
+                spec.alt = true;
+                FormatInteger(out, reinterpret_cast<uintptr_t>(va_arg(ap, void*)),
+                              false, 16, false, spec);
+                break;
+            case 's':
+                FormatString(out, va_arg(ap, const char*), spec);
+                break;
+            case 'c': {
+                const char c[2] = {static_cast<char>(va_arg(ap, int)), '\0'};
+                spec.precision = 1;
+                if (c[0] == '\0') {
+                    out.Put('\0');
+                } else {
+                    FormatString(out, c, spec);
+                }
+                break;
+            }
+            case '%':
+                out.Put('%');
+                break;
+            default:
+                // 알 수 없는 변환은 그대로 출력한다
+                out.Write(conversion_start, p - conversion_start + (*p ? 1 : 0));
+                if (*p == '\0') {
+                    continue;
+                }
+        }
+        ++p;
+    }
+
+    va_end(ap);
+    return out.Count();
+}
+
+int Format(FormatSink& sink, const char* format, ...) {
+    va_list ap;
+    va_start(ap, format);
+    const int result = VFormat(sink, format, ap);
+    va_end(ap);
+    return result;
+}
+
+int FormatTo(char* buf, size_t size, const char* format, ...) {
+    BufferSink sink{buf, size};
+    va_list ap;
+    va_start(ap, format);
+    const int result = VFormat(sink, format, ap);
+    va_end(ap);
+    return result;
+}
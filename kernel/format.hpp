@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+/** @brief 서식 결과를 한 글자씩 받아 가는 출력 대상의 인터페이스
+ *
+ * 콘솔, 시리얼 포트, 로그 링의 슬롯 등 어디든 이 인터페이스를 구현하면
+ * 중간 버퍼 없이 Format의 출력을 직접 받을 수 있다.
+ */
+class FormatSink {
+public:
+    virtual ~FormatSink() = default;
+    virtual void Put(char c) = 0;
+    virtual void Write(const char* s, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            Put(s[i]);
+        }
+    }
+};
+
+/** @brief 고정 길이 문자 배열에 서식 결과를 쓰는 FormatSink.
+ * 넘치는 글자는 버리며 항상 널 문자로 끝나도록 유지한다.
+ */
+class BufferSink : public FormatSink {
+public:
+    BufferSink(char* buf, size_t size) : buf_{buf}, size_{size}, len_{0} {
+        if (size_ > 0) {
+            buf_[0] = '\0';
+        }
+    }
+
+    void Put(char c) override {
+        if (len_ + 1 < size_) {
+            buf_[len_++] = c;
+            buf_[len_] = '\0';
+        }
+    }
+
+    /** @brief 버퍼에 실제로 기록된 글자 수(널 문자 제외) */
+    size_t Length() const { return len_; }
+
+private:
+    char* buf_;
+    size_t size_, len_;
+};
+
+/**
+ * @brief printf 호환 서식 문자열을 sink로 직접 출력하는 함수
+ * 힙이나 중간 버퍼를 쓰지 않고 전역 상태도 없으므로 인터럽트 핸들러에서도 호출할 수 있다.
+ * 지원: 플래그 - 0 + 공백 #, 폭과 정밀도(* 포함), 길이 hh h l ll z j t,
+ * 변환 d i u o x X p s c %
+ * @return 출력한 글자 수. sink가 글자를 버리더라도 서식 결과의 전체 길이를 돌려준다.
+ */
+int VFormat(FormatSink& sink, const char* format, va_list ap);
+
+int Format(FormatSink& sink, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief snprintf 대신 사용하는 함수. 결과는 항상 널 문자로 끝난다.
+ * @return 서식 결과의 전체 길이. size 이상이면 잘렸음을 뜻한다.
+ */
+int FormatTo(char* buf, size_t size, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
@@ -41,11 +41,15 @@ Error FrameBuffer::Initialize(const FrameBufferConfig &config) {
     }
 
     if (config_.frame_buffer) {
-        buffer_.resize(0);
+        buffer_.reset();
     } else {
-        buffer_.resize(bytes_per_pixel * config_.horizontal_resolution *
-                       config_.vertical_resolution);
-        config_.frame_buffer = buffer_.data();
+        const auto buffer = AllocateVirtual(bytes_per_pixel * config_.horizontal_resolution *
+                                            config_.vertical_resolution);
+        if (buffer.error) {
+            return buffer.error;
+        }
+        buffer_.reset(static_cast<uint8_t*>(buffer.value));
+        config_.frame_buffer = buffer_.get();
         config_.pixels_per_scan_line = config_.horizontal_resolution;
     }
 
@@ -115,4 +119,8 @@ void FrameBuffer::Move(Vector2D<int> dst_pos, const Rectangle<int> &src) {
             src_buf -= bytes_per_scan_line;
         }
     }
-}
\ No newline at end of file
+}
+
+int BitsPerPixel(PixelFormat format) {
+    return BytesPerPixel(format) * 8;
+}
@@ -6,6 +6,7 @@
 #include "error.hpp"
 #include "frame_buffer_config.hpp"
 #include "graphics.hpp"
+#include "vmm.hpp"
 
 class FrameBuffer {
   public:
@@ -18,7 +19,8 @@ class FrameBuffer {
 
   private:
     FrameBufferConfig config_{};
-    std::vector<uint8_t> buffer_{};
+    /** @brief config에 버퍼가 없을 때 할당하는 버퍼. 가상 영역이므로 그린 페이지만 프레임을 쓴다 */
+    std::unique_ptr<uint8_t[], VirtualMemoryDeleter> buffer_{};
     std::unique_ptr<FrameBufferWriter> writer_{};
 };
 
@@ -0,0 +1,115 @@
+#include "idle.hpp"
+
+#include <array>
+#include <limits>
+
+#include "asmfunc.h"
+#include "logger.hpp"
+#include "timer.hpp"
+
+namespace {
+    const uint64_t kNoPrediction = std::numeric_limits<uint64_t>::max();
+
+    /** @brief 유휴 방식별 통계 */
+    struct IdleModeStats {
+        /** @brief 진입 횟수 */
+        uint64_t entries;
+        /** @brief 머문 사이클의 합 */
+        uint64_t residency;
+        /** @brief 가장 길게 머문 사이클 */
+        uint64_t max_residency;
+        /** @brief 예측이 빗나간 횟수. 폴링은 시간 초과로 hlt로 넘어간 경우,
+         * hlt는 kPollThresholdMicroseconds 안에 깨어나 폴링했으면 더 빨랐을 경우
+         */
+        uint64_t mispredictions;
+    };
+
+    IdleModeStats poll_stats;
+    IdleModeStats halt_stats;
+
+    /** @brief 최근 유휴 구간 길이(사이클). 0은 빈 자리 */
+    std::array<uint64_t, kIdleHistorySize> history;
+    size_t history_pos;
+
+    void Account(IdleModeStats& stats, uint64_t cycles) {
+        ++stats.entries;
+        stats.residency += cycles;
+        if (cycles > stats.max_residency) {
+            stats.max_residency = cycles;
+        }
+    }
+
+    void RecordIdle(uint64_t cycles) {
+        history[history_pos] = cycles;
+        history_pos = (history_pos + 1) % kIdleHistorySize;
+    }
+
+    /** @brief 다음 타이머 마감까지의 사이클 수 */
+    uint64_t CyclesToNextTimer(unsigned long tick) {
+        const unsigned long deadline = timer_manager->NextDeadline();
+        const uint64_t cycles_per_tick = tsc_freq / kTimerFreq;
+        if (cycles_per_tick == 0 || deadline == std::numeric_limits<unsigned long>::max()) {
+            return kNoPrediction;
+        }
+        return deadline <= tick ? 0 : (deadline - tick) * cycles_per_tick;
+    }
+
+    /** @brief 최근 유휴 구간이 고르면 그 평균을, 들쭉날쭉하면 kNoPrediction을 반환합니다. */
+    uint64_t CyclesFromHistory() {
+        uint64_t sum = 0, max = 0;
+        for (auto cycles : history) {
+            if (cycles == 0) {
+                return kNoPrediction;
+            }
+            sum += cycles;
+            max = cycles > max ? cycles : max;
+        }
+        const uint64_t average = sum / kIdleHistorySize;
+        return max < 2 * average ? average : kNoPrediction;
+    }
+}
+
+void IdleWait(const MessageQueue& queue) {
+    const uint64_t start = ReadTSC();
+    const uint64_t poll_threshold = MicrosecondsToCycles(kPollThresholdMicroseconds);
+    const uint64_t from_timer = CyclesToNextTimer(timer_manager->CurrentTick());
+    const uint64_t from_history = CyclesFromHistory();
+    const uint64_t predicted = from_timer < from_history ? from_timer : from_history;
+
+    if (predicted < poll_threshold) {
+        // 곧 이벤트가 올 것으로 보이므로 hlt의 진입, 복귀 지연을 피해 폴링한다
+        const uint64_t poll_end = start + poll_threshold;
+        uint64_t now = start;
+        while (queue.Empty() && now < poll_end) {
+            __asm__ volatile("pause" : : : "memory");
+            now = ReadTSC();
+        }
+        Account(poll_stats, now - start);
+        if (!queue.Empty()) {
+            RecordIdle(now - start);
+            return;
+        }
+        ++poll_stats.mispredictions;
+    }
+
+    const uint64_t halt_start = ReadTSC();
+    queue.Wait();
+    const uint64_t end = ReadTSC();
+    Account(halt_stats, end - halt_start);
+    if (end - halt_start < poll_threshold) {
+        ++halt_stats.mispredictions;
+    }
+    RecordIdle(end - start);
+}
+
+void LogIdleStats() {
+    const auto log_mode = [](const char* name, const IdleModeStats& stats) {
+        Log(kInfo, "  %-4s entries %lu, residency %lu cycles (avg %lu, max %lu), mispredicted %lu\n",
+            name, stats.entries, stats.residency,
+            stats.entries ? stats.residency / stats.entries : 0,
+            stats.max_residency, stats.mispredictions);
+    };
+    Log(kInfo, "idle governor: %lu cycles per tick\n", tsc_freq / kTimerFreq);
+    log_mode("poll", poll_stats);
+    log_mode("hlt", halt_stats);
+}
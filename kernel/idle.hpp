@@ -0,0 +1,26 @@
+/**
+ * @file idle.hpp
+ *
+ * 메인 루프가 처리할 메시지가 없을 때 어떻게 기다릴지 고르는 유휴 거버너.
+ * 다음 이벤트까지의 시간을 타이머 마감과 최근 깨어남 간격으로 예측하여,
+ * 짧으면 pause로 큐를 폴링하고 길면 hlt로 잠든다.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "message_queue.hpp"
+
+/** @brief 예측한 유휴 시간이 이보다 짧으면 hlt 대신 폴링한다(마이크로초). 보정한 tsc_freq로 사이클로 바꾼다 */
+const unsigned long kPollThresholdMicroseconds = 50;
+/** @brief 예측에 쓰는 최근 유휴 구간의 수 */
+const size_t kIdleHistorySize = 8;
+
+/** @brief queue에 메시지가 들어올 때까지(또는 인터럽트로 깨어날 때까지) 기다립니다.
+ * 메인 루프에서만 호출해야 합니다.
+ */
+void IdleWait(const MessageQueue& queue);
+
+/** @brief 폴링과 hlt 각각의 진입 횟수, 체류 시간, 예측 실패 횟수를 로그로 출력합니다. */
+void LogIdleStats();
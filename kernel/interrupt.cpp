@@ -6,6 +6,8 @@
 #include "segment.hpp"
 #include "logger.hpp"
 #include "timer.hpp"
+#include "serial.hpp"
+#include "vmm.hpp"
 
 std::array<InterruptDescriptor, 256> idt;
 
@@ -27,12 +29,41 @@ void NotifyEndOfInterrupt() {
     *end_of_interrupt = 0;
 }
 
+void RouteIOAPICInterrupt(uint8_t irq, uint8_t vector, uint8_t apic_id) {
+    // 8259 PIC를 통한 중복 전달을 막기 위해 모든 IRQ를 마스크
+    IoOut8(0x21, 0xff);
+    IoOut8(0xa1, 0xff);
+
+    volatile auto ioregsel = reinterpret_cast<uint32_t*>(0xfec00000);
+    volatile auto iowin = reinterpret_cast<uint32_t*>(0xfec00010);
+    const uint32_t redirection_index = 0x10 + 2 * irq;
+
+    *ioregsel = redirection_index + 1;
+    *iowin = static_cast<uint32_t>(apic_id) << 24;
+    *ioregsel = redirection_index;
+    *iowin = vector;    // fixed, physical, active high, edge, not masked
+}
+
 namespace {
-    std::deque<Message>* msg_queue;
+    MessageQueue* msg_queue;
+
+    __attribute__((interrupt))
+    void IntHandlerPageFault(InterruptFrame* frame, uint64_t error_code) {
+        const uint64_t addr = GetCR2();
+        if (HandlePageFault(addr, error_code)) {
+            return;
+        }
+
+        Log(kError, "#PF at 0x%016lx, error code 0x%lx, rip 0x%016lx\n", addr, error_code, frame->rip);
+        FlushLog();
+        while (true) {
+            __asm__("cli\n\thlt");
+        }
+    }
 
     __attribute__((interrupt))
     void IntHandlerXHCI(InterruptFrame* frame) {
-        msg_queue->push_back(Message{Message::kInterruptXHCI});
+        msg_queue->Push(Message{Message::kInterruptXHCI});
         NotifyEndOfInterrupt();
     }
 
@@ -41,11 +72,25 @@ namespace {
         LAPICTimerOnInterrupt();
         NotifyEndOfInterrupt();
     }
+
+    __attribute__((interrupt))
+    void IntHandlerSerial(InterruptFrame* frame) {
+        if (SerialOnInterrupt()) {
+            msg_queue->Push(Message{Message::kSerialInput});
+        }
+        NotifyEndOfInterrupt();
+    }
 }
 
-void InitializeInterrupt(std::deque<Message>* msg_queue_) {
+void InitializeInterrupt(MessageQueue* msg_queue_) {
     ::msg_queue = msg_queue_;
 
+    SetIDTEntry(idt[InterruptVector::kPageFault],
+                MakeIDTAttr(DescriptorType::kInterruptGate, 0),
+                reinterpret_cast<uint64_t>(IntHandlerPageFault),
+                kKernelCS);
+    Log(kInfo, "Vector : %d, Interrupt descriptor with cs 0x%02x\n", InterruptVector::kPageFault, kKernelCS);
+
     SetIDTEntry(idt[InterruptVector::kXHCI],
                 MakeIDTAttr(DescriptorType::kInterruptGate, 0),
                 reinterpret_cast<uint64_t>(IntHandlerXHCI),
@@ -58,6 +103,12 @@ void InitializeInterrupt(std::deque<Message>* msg_queue_) {
                 kKernelCS);
     Log(kInfo, "Vector : %d, Interrupt descriptor with cs 0x%02x\n", InterruptVector::kLAPICTimer, kKernelCS);
 
+    SetIDTEntry(idt[InterruptVector::kSerial],
+                MakeIDTAttr(DescriptorType::kInterruptGate, 0),
+                reinterpret_cast<uint64_t>(IntHandlerSerial),
+                kKernelCS);
+    Log(kInfo, "Vector : %d, Interrupt descriptor with cs 0x%02x\n", InterruptVector::kSerial, kKernelCS);
+
     LoadIDT(sizeof(idt) - 1, reinterpret_cast<uintptr_t>(&idt[0]));
-    Log(kInfo, "IDT : 0x%08x Loaded\n", reinterpret_cast<uintptr_t>(&(idt[0])));
+    Log(kInfo, "IDT : 0x%08lx Loaded\n", reinterpret_cast<uintptr_t>(&(idt[0])));
 }
\ No newline at end of file
@@ -2,10 +2,9 @@
 
 #include <array>
 #include <cstdint>
-#include <deque>
 
 #include "x86_descriptor.hpp"
-#include "message.hpp"
+#include "message_queue.hpp"
 
 /**
  * @brief 인터럽트 기술자 속성, type으로 인터럽트와 트랩을 구분함. DPL은 인터럽트가 핸들링 되는 권한레벨
@@ -75,8 +74,10 @@ void SetIDTEntry(
 class InterruptVector {
 public:
     enum Number {
+        kPageFault = 0x0e,
         kXHCI = 0x40,
-        kLAPICTimer = 0x41
+        kLAPICTimer = 0x41,
+        kSerial = 0x42,
     };
 };
 
@@ -90,4 +91,40 @@ struct InterruptFrame {
 
 void NotifyEndOfInterrupt();
 
-void InitializeInterrupt(std::deque<Message>* msg_queue);
\ No newline at end of file
+/** @brief 실행 중인 CPU의 Local APIC ID */
+inline uint8_t LocalAPICID() {
+    return *reinterpret_cast<const volatile uint32_t*>(0xfee00020) >> 24;
+}
+
+/**
+ * @brief I/O APIC의 리다이렉션 테이블에 외부 인터럽트를 등록
+ * 엣지 트리거, active high, fixed 전달 모드로 설정하며 레거시 8259 PIC는 모두 마스크한다
+ * @param irq I/O APIC 입력 핀 번호(GSI)
+ * @param vector 전달할 인터럽트 벡터
+ * @param apic_id 인터럽트를 받을 Local APIC ID
+ */
+void RouteIOAPICInterrupt(uint8_t irq, uint8_t vector, uint8_t apic_id);
+
+/**
+ * @brief 생성 시 인터럽트를 금지하고, 소멸 시 생성 전의 인터럽트 허가 상태로 되돌리는 클래스
+ * 인터럽트 핸들러와 공유하는 자료구조를 메인 루프에서 짧게 조작할 때 사용
+ */
+class InterruptGuard {
+public:
+    InterruptGuard() {
+        __asm__ volatile("pushfq\n\tpopq %0\n\tcli" : "=r"(rflags_) : : "memory");
+    }
+    ~InterruptGuard() {
+        __asm__ volatile("pushq %0\n\tpopfq" : : "r"(rflags_) : "memory", "cc");
+    }
+    InterruptGuard(const InterruptGuard&) = delete;
+    InterruptGuard& operator=(const InterruptGuard&) = delete;
+
+    /** @brief 가드 생성 전에 인터럽트가 허가되어 있었는지 여부 */
+    bool WasEnabled() const { return rflags_ & (1u << 9); }
+
+private:
+    uint64_t rflags_;
+};
+
+void InitializeInterrupt(MessageQueue* msg_queue);
\ No newline at end of file
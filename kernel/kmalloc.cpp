@@ -0,0 +1,202 @@
+#include "kmalloc.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "interrupt.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "memstat.hpp"
+#include "slab.hpp"
+#include "zero_pool.hpp"
+
+namespace {
+    /** @brief 크기 클래스. 블록 헤더를 포함한 크기이며 이보다 크면 프레임을 직접 할당한다. */
+    const std::array<size_t, 15> kSizeClasses{
+        32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096,
+    };
+    const std::array<const char*, kSizeClasses.size()> kSizeClassNames{
+        "kmalloc-32", "kmalloc-48", "kmalloc-64", "kmalloc-96", "kmalloc-128",
+        "kmalloc-192", "kmalloc-256", "kmalloc-384", "kmalloc-512", "kmalloc-768",
+        "kmalloc-1024", "kmalloc-1536", "kmalloc-2048", "kmalloc-3072", "kmalloc-4096",
+    };
+    const size_t kMinAlignment = 16;
+    /** @brief CPU별 캐시가 크기 클래스마다 보관하는 최대 블록 수 */
+    const size_t kMagazineSize = 16;
+    const unsigned int kMaxCPUs = 4;
+
+    enum class BlockKind : uint16_t {
+        kSmall = 0x6b73,
+        kLarge = 0x6b6c,
+    };
+
+    /** @brief 사용자에게 돌려주는 포인터 바로 앞에 두는 헤더 */
+    struct BlockHeader {
+        BlockKind kind;
+        uint8_t size_class;
+        /** @brief 할당 시점의 HeapCategory. 해제 시 같은 범주에서 뺀다 */
+        HeapCategory category;
+        /** @brief 블록 선두에서 사용자 포인터까지의 바이트 수 */
+        uint32_t offset;
+        /** @brief kLarge일 때 할당한 프레임 수 */
+        size_t frames;
+    };
+    static_assert(sizeof(BlockHeader) == kMinAlignment);
+
+    /** @brief CPU 하나, 크기 클래스 하나의 캐시. 슬랩 캐시를 거치지 않고 블록을 주고받는다. */
+    struct Magazine {
+        size_t count;
+        std::array<void*, kMagazineSize> blocks;
+    };
+
+    std::array<std::array<Magazine, kSizeClasses.size()>, kMaxCPUs> magazines;
+
+    alignas(SlabCache) char class_cache_buf[kSizeClasses.size()][sizeof(SlabCache)];
+    std::array<SlabCache*, kSizeClasses.size()> class_caches;
+
+    SlabCache& ClassCache(size_t size_class) {
+        if (class_caches[size_class] == nullptr) {
+            class_caches[size_class] = new(class_cache_buf[size_class]) SlabCache{
+                kSizeClassNames[size_class], kSizeClasses[size_class], kMinAlignment};
+        }
+        return *class_caches[size_class];
+    }
+
+    /** @brief block_size 바이트가 들어가는 가장 작은 크기 클래스. 없으면 -1 */
+    int SizeClassOf(size_t block_size) {
+        for (size_t i = 0; i < kSizeClasses.size(); ++i) {
+            if (block_size <= kSizeClasses[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    Magazine& CurrentMagazine(size_t size_class) {
+        return magazines[LocalAPICID() % kMaxCPUs][size_class];
+    }
+
+    void* AllocateSmall(size_t size_class) {
+        auto& magazine = CurrentMagazine(size_class);
+        if (magazine.count == 0) {
+            // 절반만 채워 두어 곧이어 해제가 이어져도 바로 넘치지 않게 한다
+            auto& cache = ClassCache(size_class);
+            while (magazine.count < kMagazineSize / 2) {
+                void* block = cache.Allocate();
+                if (block == nullptr) {
+                    break;
+                }
+                magazine.blocks[magazine.count++] = block;
+            }
+            if (magazine.count == 0) {
+                return nullptr;
+            }
+        }
+        return magazine.blocks[--magazine.count];
+    }
+
+    void FreeSmall(size_t size_class, void* block) {
+        auto& magazine = CurrentMagazine(size_class);
+        if (magazine.count == kMagazineSize) {
+            auto& cache = ClassCache(size_class);
+            while (magazine.count > kMagazineSize / 2) {
+                cache.Free(magazine.blocks[--magazine.count]);
+            }
+        }
+        magazine.blocks[magazine.count++] = block;
+    }
+
+    void* AllocateLarge(size_t block_size, size_t& frames) {
+        frames = (block_size + kBytesPerFrame - 1) / kBytesPerFrame;
+        const auto frame = AllocateFrames(frames, FrameOwner::kKmalloc);
+        if (frame.error) {
+            return nullptr;
+        }
+        return frame.value.Frame();
+    }
+}
+
+extern "C" void* KernelMalloc(size_t size, size_t alignment) {
+    alignment = alignment < kMinAlignment ? kMinAlignment : alignment;
+    if ((alignment & (alignment - 1)) != 0 || size > SIZE_MAX - alignment) {
+        return nullptr;
+    }
+
+    // 블록은 최소 kMinAlignment 경계에 있으므로 헤더와 정렬용 여백은 alignment 바이트로 충분하다
+    const size_t block_size = size + alignment;
+    const int size_class = SizeClassOf(block_size);
+
+    InterruptGuard guard;
+    BlockHeader header{BlockKind::kSmall, 0, CurrentHeapCategory(), 0, 0};
+    void* block;
+    if (size_class >= 0) {
+        header.size_class = size_class;
+        block = AllocateSmall(size_class);
+    } else {
+        header.kind = BlockKind::kLarge;
+        block = AllocateLarge(block_size, header.frames);
+    }
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    const auto block_addr = reinterpret_cast<uintptr_t>(block);
+    const auto addr = (block_addr + sizeof(BlockHeader) + alignment - 1) & ~(alignment - 1);
+    header.offset = addr - block_addr;
+    reinterpret_cast<BlockHeader*>(addr)[-1] = header;
+    AccountHeap(header.category, KernelMallocUsableSize(reinterpret_cast<void*>(addr)));
+    return reinterpret_cast<void*>(addr);
+}
+
+extern "C" void KernelFree(void* p) {
+    if (p == nullptr) {
+        return;
+    }
+
+    auto& header = reinterpret_cast<BlockHeader*>(p)[-1];
+    void* block = reinterpret_cast<uint8_t*>(p) - header.offset;
+
+    InterruptGuard guard;
+    switch (header.kind) {
+        case BlockKind::kSmall:
+            AccountHeap(header.category, -static_cast<long>(KernelMallocUsableSize(p)));
+            header.kind = {};
+            FreeSmall(header.size_class, block);
+            break;
+        case BlockKind::kLarge:
+            AccountHeap(header.category, -static_cast<long>(KernelMallocUsableSize(p)));
+            header.kind = {};
+            FreeFrames(FrameID{reinterpret_cast<uintptr_t>(block) / kBytesPerFrame},
+                       header.frames, FrameOwner::kKmalloc);
+            break;
+        default:
+            Log(kError, "KernelFree: invalid or double freed pointer %p\n", p);
+    }
+}
+
+void FlushKernelMallocCaches() {
+    InterruptGuard guard;
+    for (auto& cpu_magazines : magazines) {
+        for (size_t size_class = 0; size_class < kSizeClasses.size(); ++size_class) {
+            auto& magazine = cpu_magazines[size_class];
+            while (magazine.count > 0) {
+                ClassCache(size_class).Free(magazine.blocks[--magazine.count]);
+            }
+        }
+    }
+}
+
+extern "C" size_t KernelMallocUsableSize(void* p) {
+    if (p == nullptr) {
+        return 0;
+    }
+
+    const auto& header = reinterpret_cast<const BlockHeader*>(p)[-1];
+    switch (header.kind) {
+        case BlockKind::kSmall:
+            return kSizeClasses[header.size_class] - header.offset;
+        case BlockKind::kLarge:
+            return header.frames * kBytesPerFrame - header.offset;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file kmalloc.hpp
+ *
+ * 크기 클래스별 슬랩 캐시와 CPU별 캐시로 구성된 커널 malloc.
+ * newlib_support.c의 malloc, free, posix_memalign 등이 이 함수들을 호출한다.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+extern "C" {
+    /** @brief size 바이트를 alignment(2의 거듭제곱) 경계에 맞춰 할당합니다.
+     * 인터럽트를 금지한 채 동작하므로 인터럽트 핸들러에서도 호출할 수 있습니다.
+     *
+     * @return 할당한 영역. 실패하면 nullptr
+     */
+    void* KernelMalloc(size_t size, size_t alignment);
+    /** @brief KernelMalloc으로 할당한 영역을 해제합니다. nullptr이면 아무것도 하지 않습니다. */
+    void KernelFree(void* p);
+    /** @brief p에서 실제로 사용할 수 있는 바이트 수 */
+    size_t KernelMallocUsableSize(void* p);
+}
+
+/** @brief CPU별 캐시에 보관한 블록을 모두 슬랩 캐시로 돌려줍니다. 메모리 회수 시 호출합니다. */
+void FlushKernelMallocCaches();
@@ -2,6 +2,9 @@
 #include "frame_buffer.hpp"
 #include "logger.hpp"
 #include "console.hpp"
+#include "memory_manager.hpp"
+#include "memstat.hpp"
+#include "reclaim.hpp"
 
 #include <algorithm>
 
@@ -63,12 +66,23 @@ void LayerManager::Draw(const Rectangle<int>& area) const {
 }
 
 void LayerManager::Draw(unsigned int id) const {
+    for (auto layer : layer_stack_) {
+        if (layer->ID() == id) {
+            Draw(id, {{0, 0}, layer->GetWindow()->Size()});
+            return;
+        }
+    }
+}
+
+void LayerManager::Draw(unsigned int id, Rectangle<int> area) const {
     bool draw = false;
-    Rectangle<int> window_area;
+    Rectangle<int> window_area{};
     for (auto layer : layer_stack_) {
         if (layer->ID() == id) {
             window_area.size = layer->GetWindow()->Size();
             window_area.pos = layer->GetPosition();
+            area.pos += window_area.pos;
+            window_area = window_area & area;
             draw = true;
         }
         if (draw) {
@@ -87,6 +101,9 @@ void LayerManager::Move(unsigned int id, Vector2D<int> new_position) {
     const auto window_size = layer->GetWindow()->Size();
     const auto old_pos = layer->GetPosition();
     layer->Move(new_position);
+    if (IsVisible(layer)) {
+        layer->GetWindow()->RestoreSurface();
+    }
     Draw({old_pos, window_size});
     Draw(id);
 }
@@ -96,6 +113,9 @@ void LayerManager::MoveRelative(unsigned int id, Vector2D<int> pos_diff) {
     const auto window_size = layer->GetWindow()->Size();
     const auto old_pos = layer->GetPosition();
     layer->MoveRelative(pos_diff);
+    if (IsVisible(layer)) {
+        layer->GetWindow()->RestoreSurface();
+    }
     Draw({old_pos, window_size});
     Draw(id);
 }
@@ -112,6 +132,9 @@ void LayerManager::UpDown(unsigned int id, int new_height) {
     auto layer = FindLayer(id);
     auto old_pos = std::find(layer_stack_.begin(), layer_stack_.end(), layer);
     auto new_pos = layer_stack_.begin() + new_height;
+    if (auto window = layer->GetWindow()) {
+        window->RestoreSurface();
+    }
 
     if (old_pos == layer_stack_.end()) {
         layer_stack_.insert(new_pos, layer);
@@ -144,6 +167,54 @@ Layer *LayerManager::FindLayer(unsigned int id) {
     return it->get();
 }
 
+bool LayerManager::IsVisible(Layer* layer) const {
+    if (std::find(layer_stack_.begin(), layer_stack_.end(), layer) == layer_stack_.end()) {
+        return false;
+    }
+    const auto window = layer->GetWindow();
+    const Rectangle<int> window_area{layer->GetPosition(), window->Size()};
+    const auto visible_area = window_area & Rectangle<int>{{0, 0}, ScreenSize()};
+    return visible_area.size.x > 0 && visible_area.size.y > 0;
+}
+
+size_t LayerManager::ReleaseHiddenSurfaces(size_t bytes_wanted) {
+    size_t bytes = 0;
+    for (const auto& layer : layers_) {
+        if (bytes >= bytes_wanted) {
+            break;
+        }
+        const auto window = layer->GetWindow();
+        if (!window || IsVisible(layer.get())) {
+            continue;
+        }
+        const bool shown_elsewhere = std::any_of(
+            layer_stack_.begin(), layer_stack_.end(),
+            [&](Layer* other) { return other->GetWindow() == window && IsVisible(other); });
+        if (!shown_elsewhere) {
+            bytes += window->ReleaseSurface();
+        }
+    }
+    return bytes;
+}
+
+void LayerManager::LogSurfaceStats() const {
+    size_t total = 0;
+    for (const auto& layer : layers_) {
+        const auto window = layer->GetWindow();
+        if (!window) {
+            continue;
+        }
+        const size_t bytes = window->SurfaceBytes();
+        total += bytes;
+        Log(kInfo, "memstat: layer %u %dx%d %lu bytes\n",
+            layer->ID(), window->Width(), window->Height(), bytes);
+    }
+    Log(kInfo, "memstat: layers %lu bytes, back buffer %lu bytes\n", total,
+        static_cast<size_t>(back_buffer_.Config().horizontal_resolution) *
+        back_buffer_.Config().vertical_resolution *
+        BitsPerPixel(back_buffer_.Config().pixel_format) / 8);
+}
+
 Layer* LayerManager::FindLayerByPosition(Vector2D<int> pos, unsigned int exclude_id) const {
     auto pred = [pos, exclude_id](Layer* layer) {
         if (layer->ID() == exclude_id) {
@@ -172,13 +243,15 @@ namespace {
 LayerManager* layer_manager;
 
 void InitializeLayer() {
+    HeapCategoryScope heap_category{HeapCategory::kGraphics};
     const auto screen_size = ScreenSize();
 
-    auto bgwindow = std::make_shared<Window>(
+    auto bgwindow = MakeSlabShared<Window>(
             screen_size.x, screen_size.y, screen_config.pixel_format);
     DrawDesktop(*bgwindow->Writer());
+    bgwindow->SetRedrawCallback([](Window& window) { DrawDesktop(*window.Writer()); });
 
-    auto console_window = std::make_shared<Window>(
+    auto console_window = MakeSlabShared<Window>(
             Console::kColumns * 8, Console::kRows * 16, screen_config.pixel_format);
     console->SetWindow(console_window);
 
@@ -203,4 +276,8 @@ void InitializeLayer() {
 
     layer_manager->UpDown(bglayer_id, 0);
     layer_manager->UpDown(console->LayerID(), 1);
+
+    RegisterReclaimHook("layer surfaces", [](size_t frames_wanted) -> size_t {
+        return layer_manager->ReleaseHiddenSurfaces(frames_wanted * kBytesPerFrame) / kBytesPerFrame;
+    });
 }
\ No newline at end of file
@@ -6,14 +6,16 @@
 #include <vector>
 
 #include "graphics.hpp"
+#include "slab.hpp"
 #include "window.hpp"
 
 /** @brief Layer 는 1 개의 층을 나타낸다.
  *
  * 현재 상태에서는 하나의 창만 유지할 수 있는 설계이지만,
  * 미래에는 여러 개의 창을 가질 수 있습니다.
+ * 자주 만들고 지우므로 전용 슬랩 캐시에서 할당한다.
  */
-class Layer {
+class Layer : public SlabAllocated<Layer> {
 public:
     /** @brief 지정된 ID를 가진 레이어를 생성합니다. */
     Layer(unsigned int id = 0);
@@ -58,7 +60,13 @@ public:
     /** @brief 현재 표시 상태에 있는 레이어를 그립니다. */
     void Draw(const Rectangle<int>& area) const;
 
+    /** @brief 지정된 레이어와 그 위의 레이어들을 레이어 영역 전체에 대해 다시 그립니다. */
     void Draw(unsigned int id) const;
+    /** @brief 지정된 레이어와 그 위의 레이어들을 다시 그립니다.
+     *
+     * @param area 다시 그릴 영역. 레이어의 좌상단을 원점으로 하는 좌표계로 지정합니다.
+     */
+    void Draw(unsigned int id, Rectangle<int> area) const;
 
     /** @brief 레이어의 위치 정보를 지정된 절대 좌표로 업데이트합니다. 다시 그리지는 않습니다. */
     void Move(unsigned int id, Vector2D<int> new_position);
@@ -77,6 +85,18 @@ public:
 
     Layer* FindLayerByPosition(Vector2D<int> pos, unsigned int exclude_id) const;
 
+    /** @brief 레이어마다 창 표면이 차지하는 바이트 수를 로그로 출력합니다. */
+    void LogSurfaceStats() const;
+
+    /** @brief 숨겨졌거나 화면 밖에 있는 레이어의 창 표면을 해제합니다.
+     * 표시 중인 다른 레이어와 공유하는 창은 해제하지 않습니다.
+     * 해제한 표면은 UpDown이나 Move로 다시 보일 때 재묘화 콜백으로 복원됩니다.
+     *
+     * @param bytes_wanted 이만큼 해제하면 멈춘다
+     * @return 해제한 바이트 수
+     */
+    size_t ReleaseHiddenSurfaces(size_t bytes_wanted);
+
 private:
     FrameBuffer* screen_{ nullptr };
     mutable FrameBuffer back_buffer_{};
@@ -85,6 +105,8 @@ private:
     unsigned int latest_id_{0};
 
     Layer* FindLayer(unsigned int id);
+    /** @brief 레이어가 표시 중이고 화면과 겹치는지 여부 */
+    bool IsVisible(Layer* layer) const;
 };
 
 extern LayerManager* layer_manager;
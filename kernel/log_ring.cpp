@@ -0,0 +1,60 @@
+#include "log_ring.hpp"
+
+#include "asmfunc.h"
+#include "format.hpp"
+
+namespace {
+    /** @brief 서식 결과의 앞 skip 글자를 건너뛰고 나머지를 버퍼에 쓰는 FormatSink */
+    class SkipSink : public FormatSink {
+    public:
+        SkipSink(char* buf, size_t size, size_t skip) : buffer_{buf, size}, skip_{skip} {}
+
+        void Put(char c) override {
+            if (skip_ > 0) {
+                --skip_;
+            } else {
+                buffer_.Put(c);
+            }
+        }
+
+        size_t Length() const { return buffer_.Length(); }
+
+    private:
+        BufferSink buffer_;
+        size_t skip_;
+    };
+}
+
+int LogRing::Write(LogLevel level, const char* format, va_list ap) {
+    // 레코드마다 처음부터 다시 서식하고 이미 기록한 앞부분을 건너뛴다.
+    // 긴 메시지만 여러 번 서식하므로 짧은 메시지의 비용은 그대로다
+    size_t written = 0;
+    size_t total = 0;
+    uint64_t first_sequence = 0;
+    bool recorded = false;
+    do {
+        va_list aq;
+        va_copy(aq, ap);
+        const bool pushed = ring_.PushWith([&](LogRecord& record, uint64_t sequence) {
+            if (written == 0) {
+                first_sequence = sequence;
+            }
+            record.sequence = first_sequence;
+            record.tsc = ReadTSC();
+            record.level = level;
+            record.continued = written > 0;
+            const size_t size = kLogMessageMaxLength - written + 1;
+            SkipSink sink{record.text, size < sizeof(record.text) ? size : sizeof(record.text), written};
+            total = VFormat(sink, format, aq);
+            record.length = sink.Length();
+            written += record.length;
+        });
+        va_end(aq);
+        if (!pushed) {
+            break;   // 나머지 조각은 버려지고 Dropped에 계수된다
+        }
+        recorded = true;
+    } while (written < total && written < kLogMessageMaxLength);
+
+    return recorded ? static_cast<int>(written) : -1;
+}
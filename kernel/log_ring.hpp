@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+
+#include "logger.hpp"
+#include "mpsc_ring.hpp"
+
+/** @brief 로그 레코드 1개에 담을 수 있는 최대 문자열 길이(종단 문자 포함) */
+const size_t kLogRecordTextSize = 104;
+/** @brief 로그 메시지 1건의 최대 길이(종단 문자 제외). 이보다 긴 부분은 버린다. */
+const size_t kLogMessageMaxLength = 1023;
+
+/** @brief 로그 링에 저장되는 레코드 1개 */
+struct LogRecord {
+    /** @brief 메시지의 일련번호. 한 메시지를 나눈 레코드는 모두 첫 레코드의 번호를 가진다. */
+    uint64_t sequence;
+    /** @brief 기록 시점의 TSC 값 */
+    uint64_t tsc;
+    LogLevel level;
+    /** @brief text에 담긴 문자열 길이 */
+    int length;
+    /** @brief 앞 레코드에서 이어지는 메시지 조각이면 true */
+    bool continued;
+    char text[kLogRecordTextSize];
+};
+
+/** @brief 인터럽트 핸들러에서도 기록할 수 있는 로그 링.
+ * MpscRing 위에서 레코드를 슬롯 안에 직접 서식하며, 링의 일련번호를 레코드의 sequence로 쓴다.
+ * 한 레코드에 들어가지 않는 메시지는 kLogMessageMaxLength까지 연속된 레코드로 나눠 기록한다.
+ * 나눈 레코드 사이에 인터럽트 핸들러의 로그가 끼어들 수 있다.
+ */
+class LogRing {
+public:
+    /** @brief 링의 슬롯 수. 2의 거듭제곱이어야 한다. */
+    static const size_t kCapacity = 1024;
+
+    /** @brief 서식 문자열을 슬롯에 직접 서식하여 기록합니다.
+     * @return 기록된 문자열 길이. 링이 가득 차 하나도 기록하지 못한 경우 -1
+     */
+    int Write(LogLevel level, const char* format, va_list ap)
+        __attribute__((format(printf, 3, 0)));
+
+    /** @brief 가장 오래된 레코드를 꺼냅니다. 단일 소비자에서만 호출해야 합니다.
+     * @return 꺼낸 레코드가 있으면 true
+     */
+    bool Read(LogRecord& record) { return ring_.Pop(record); }
+
+    /** @brief 링이 가득 차서 버려진 레코드의 누적 개수 */
+    uint64_t Dropped() const { return ring_.Dropped(); }
+
+private:
+    MpscRing<LogRecord, kCapacity> ring_;
+};
@@ -1,22 +1,61 @@
 #include "logger.hpp"
 
+#include <array>
 #include <cstddef>
-#include <cstdio>
 #include <cstdarg>
 
-#include "console.hpp"
+#include "asmfunc.h"
+#include "format.hpp"
+#include "log_ring.hpp"
 
 namespace {
     LogLevel log_level = kWarn;
-}
 
-extern Console* console;
+    LogRing log_ring;
+
+    const size_t kMaxLogSinks = 4;
+    std::array<LogSink*, kMaxLogSinks> log_sinks{};
+
+    bool deferred = false;
+    bool flushing = false;
+    uint64_t reported_dropped = 0;
+
+    void WriteToSinks(const LogRecord& record) {
+        for (auto sink : log_sinks) {
+            if (sink) {
+                sink->Write(record);
+            }
+        }
+    }
+
+    void FlushSinks() {
+        for (auto sink : log_sinks) {
+            if (sink) {
+                sink->Flush();
+            }
+        }
+    }
+}
 
 void SetLogLevel(LogLevel level) {
     log_level = level;
 }
 
-extern int printk(const char* format, ...);
+int LogV(LogLevel level, const char* format, va_list ap) {
+    const int result = log_ring.Write(level, format, ap);
+    if (!deferred) {
+        FlushLog();
+    }
+    return result;
+}
+
+int printk(const char* format, ...) {
+    va_list ap;
+    va_start(ap, format);
+    const int result = LogV(kInfo, format, ap);
+    va_end(ap);
+    return result;
+}
 
 int Log(LogLevel level, const char* format, ...) {
     if (level > log_level) {
@@ -24,15 +63,49 @@ int Log(LogLevel level, const char* format, ...) {
     }
 
     va_list ap;
-    int result;
-    char s[1024];
-
     va_start(ap, format);
-    result = vsprintf(s, format, ap);
+    const int result = LogV(level, format, ap);
     va_end(ap);
+    return result;
+}
 
-    printk(s);
+bool AddLogSink(LogSink* sink) {
+    for (auto& s : log_sinks) {
+        if (s == nullptr) {
+            s = sink;
+            return true;
+        }
+    }
+    return false;
+}
 
-    // console->PutString(s);
-    return result;
-}
\ No newline at end of file
+void FlushLog() {
+    if (flushing) {
+        return;
+    }
+    flushing = true;
+
+    LogRecord record;
+    while (log_ring.Read(record)) {
+        WriteToSinks(record);
+    }
+
+    if (const auto dropped = log_ring.Dropped(); dropped != reported_dropped) {
+        record.sequence = 0;
+        record.tsc = ReadTSC();
+        record.level = kWarn;
+        record.continued = false;
+        BufferSink sink{record.text, sizeof(record.text)};
+        Format(sink, "log: %lu records dropped\n", dropped - reported_dropped);
+        record.length = sink.Length();
+        reported_dropped = dropped;
+        WriteToSinks(record);
+    }
+    FlushSinks();
+
+    flushing = false;
+}
+
+void EnableDeferredLogging() {
+    deferred = true;
+}
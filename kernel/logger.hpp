@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdarg>
+
 enum LogLevel {
     kError = 3,
     kWarn = 4,
@@ -7,6 +9,17 @@ enum LogLevel {
     kDebug = 7,
 };
 
+struct LogRecord;
+
+/** @brief 로그 링에서 꺼낸 레코드를 출력하는 대상(콘솔 등)의 인터페이스 */
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void Write(const LogRecord& record) = 0;
+    /** @brief FlushLog가 레코드를 모두 전달한 뒤 호출됩니다. 버퍼링하는 싱크는 여기서 출력을 반영합니다. */
+    virtual void Flush() {}
+};
+
 /**
  * @brief 전역 로그레벨을 설정하는 함수
  * @param level 설정할 로그레벨
@@ -14,14 +27,49 @@ enum LogLevel {
 void SetLogLevel(LogLevel level);
 
 /**
- * @brief 주어진 로그레벨의 로그를 출력하는 함수
+ * @brief 주어진 로그레벨의 로그를 로그 링에 기록하는 함수
  * 초기 전역 로그레벨은 kWarn이며, 전역 로그레벨보다 높은 수준의 레벨의 로그만 실제 로깅됨
+ * 락을 사용하지 않으므로 인터럽트 핸들러에서도 호출할 수 있음
  * @param level 로깅을 시도할 로그레벨
  * @param format 서식 문자열
  * @param ... 문자열을 서식할 가변인자 리스트
  * @return int 성공 여부
  * - 0 : 로깅하지 않음
  * - >0 : 로깅된 문자열의 크기
- * - <0 : vsprintf 에러
+ * - <0 : 로그 링이 가득 차서 버려짐
+ */
+int Log(LogLevel level, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief 로그레벨 검사 없이 va_list로 받은 서식 문자열을 로그 링에 기록하는 함수
+ * @return Log와 동일
+ */
+int LogV(LogLevel level, const char* format, va_list ap)
+    __attribute__((format(printf, 2, 0)));
+
+/**
+ * @brief 로그레벨과 관계없이 항상 kInfo 레벨로 로그 링에 기록하는 함수
+ * @return Log와 동일
+ */
+int printk(const char* format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief 로그를 출력할 싱크를 등록하는 함수
+ * @return 등록할 자리가 없으면 false
+ */
+bool AddLogSink(LogSink* sink);
+
+/**
+ * @brief 로그 링에 쌓인 레코드를 모두 꺼내 등록된 싱크로 출력하는 함수
+ * 로그 링의 유일한 소비자이므로 인터럽트 핸들러에서 호출해서는 안 됨
+ */
+void FlushLog();
+
+/**
+ * @brief 로그 출력을 지연 모드로 전환하는 함수
+ * 부팅 직후에는 Log 호출마다 즉시 FlushLog를 수행하며,
+ * 지연 모드 이후에는 메인 루프가 FlushLog를 호출할 때까지 출력이 미뤄짐
  */
-int Log(LogLevel level, const char* format, ...);
\ No newline at end of file
+void EnableDeferredLogging();
@@ -7,6 +7,7 @@
 #include "graphics.hpp"
 #include "font.hpp"
 #include "console.hpp"
+#include "format.hpp"
 #include "pci.hpp"
 #include "logger.hpp"
 #include "usb/xhci/xhci.hpp"
@@ -14,32 +15,31 @@
 #include "interrupt.hpp"
 #include "segment.hpp"
 #include "paging.hpp"
+#include "acpi.hpp"
+#include "clocksource.hpp"
 #include "memory_manager.hpp"
 #include "window.hpp"
 #include "layer.hpp"
 #include "timer.hpp"
+#include "message_queue.hpp"
+#include "serial.hpp"
+#include "slab.hpp"
+#include "trace.hpp"
+#include "zero_pool.hpp"
+#include "memstat.hpp"
+#include "reclaim.hpp"
+#include "idle.hpp"
+#include "asmfunc.h"
 
 
-int printk(const char* format, ...) {
-    va_list ap;
-    int result;
-    char s[1024];
-
-    va_start(ap, format);
-    result = vsprintf(s, format, ap);
-    va_end(ap);
-
-    console->PutString(s);
-
-    return result;
-}
-
 std::shared_ptr<Window> main_window;
 unsigned int main_window_layer_id;
 void InitializeMainWindow() {
-    main_window = std::make_shared<Window>(
+    HeapCategoryScope heap_category{HeapCategory::kGraphics};
+    main_window = MakeSlabShared<Window>(
             160, 52, screen_config.pixel_format);
     DrawWindow(*main_window->Writer(), "Hello Window");
+    main_window->SetRedrawCallback([](Window& window) { DrawWindow(*window.Writer(), "Hello Window"); });
 
     main_window_layer_id = layer_manager->NewLayer()
             .SetWindow(main_window)
@@ -57,28 +57,83 @@ alignas(16) uint8_t kernel_main_stack[1024 * 1024];
 
 /**
  * @brief 외부 인터럽트 발생에 따른 Message객체를 저장하는 FIFO
+ * 모든 멤버가 0인 상태가 빈 큐이므로 BSS에 그대로 둔다
  */
-std::deque<Message>* main_queue;
+MessageQueue main_queue;
+
+/** @brief 메인 루프가 한 번 깨어났을 때 메시지 처리에 쓰는 최대 시간(마이크로초) */
+const unsigned long kDispatchBudgetMicroseconds = 1000;
+
+/** @brief 시리얼로 받은 디버그 명령을 모두 처리합니다. */
+void ProcessSerialCommands() {
+    char command;
+    while (serial_port && serial_port->Read(&command, 1) == 1) {
+        switch (command) {
+            case 't':
+                StartTraceDump(*serial_port);
+                break;
+            case 's':
+                LogSlabStats();
+                break;
+            case 'm':
+                LogMemoryStats();
+                break;
+            case 'r':
+                Log(kInfo, "reclaimed %lu frames\n", ReclaimMemory(kHighWatermarkFrames));
+                break;
+            case 'i':
+                LogIdleStats();
+                break;
+        }
+    }
+}
+
+/** @brief 메시지 하나를 종류에 맞게 처리합니다. */
+void DispatchMessage(const Message& msg) {
+    switch (msg.type) {
+        case Message::kNull:
+            break;
+        case Message::kSerialInput:
+            ProcessSerialCommands();
+            ContinueTraceDump();
+            break;
+        case Message::kInterruptXHCI:
+            usb::xhci::ProcessEvents();
+            break;
+        case Message::kTimerTimeout:
+            printk("Timer: timeout = %lu, value = %d\n",
+                   msg.arg.timer.timeout, msg.arg.timer.value);
+            if (msg.arg.timer.value > 0) {
+                timer_manager->AddTimer(
+                        Timer(msg.arg.timer.timeout + MillisecondsToTicks(1000), msg.arg.timer.value + 1));
+            }
+            break;
+        default:
+            Log(kError, "Unknown message type: %d\n", msg.type);
+    }
+}
 
 /**
  * @brief 커널의 엔트리포인트 
  * @param frame_buffer_config FrameBufferConfig 타입, BIOS로부터 받아온 프레임 버퍼와 그 정보 
  * @param memory_map MemoryMap 타입, UEFI로부터 받아온 메모리 맵 정보
+ * @param acpi_table UEFI 설정 테이블에서 찾은 ACPI 2.0 RSDP. 찾지 못했으면 nullptr
  */
-extern "C" void KernelMainNewStack(const FrameBufferConfig& frame_buffer_config_ref, const MemoryMap& memory_map_ref) {
+extern "C" void KernelMainNewStack(const FrameBufferConfig& frame_buffer_config_ref, const MemoryMap& memory_map_ref,
+                                   const acpi::RSDP* acpi_table) {
     InitializeGraphics(frame_buffer_config_ref);
     InitializeConsole();
+    InitializeSerial();
 
     printk("Welcome to MikanOS!\n");
     SetLogLevel(kInfo);
 
     InitializeSegmentation();
-    InitializePaging();
-
     InitializeMemoryManager(memory_map_ref);
+    InitializePaging(memory_map_ref);
+    ReleaseBootServicesMemory(memory_map_ref);
 
-    ::main_queue = new std::deque<Message>(32);
-    InitializeInterrupt(main_queue);
+    InitializeInterrupt(&main_queue);
 
     InitializePCI();
     usb::xhci::Initialize();
@@ -87,55 +142,69 @@ extern "C" void KernelMainNewStack(const FrameBufferConfig& frame_buffer_config_
     InitializeMainWindow();
     InitializeMouse();
 
-    InitializeLAPICTimer(*main_queue);
+    acpi::Initialize(acpi_table);
+    InitializeLAPICTimer(main_queue);
+    InitializeClockSource();
 
-    timer_manager->AddTimer(Timer(100, 1));
-    timer_manager->AddTimer(Timer(500, -1));
+    timer_manager->AddTimerAfterMilliseconds(1000, 1);
+    timer_manager->AddTimerAfterMilliseconds(5000, -1);
 
     layer_manager->Draw({{0, 0}, ScreenSize()});
 
     char str[128];
-    uint32_t count = 0;
+    // 틱 단위는 빌드 설정에 따라 다르므로 카운터는 밀리초로 표시한다
+    unsigned long count = 0;
+    bool count_drawn = false;
+    uint64_t reported_drops = 0;
+
+    // 보정한 TSC 주파수로 예산을 사이클로 바꿔 둔다
+    const uint64_t dispatch_budget = MicrosecondsToCycles(kDispatchBudgetMicroseconds);
 
+    EnableDeferredLogging();
     __asm__("sti");
     /**
      * @brief 외부 인터럽트 이벤트 루프
+     * 깨어날 때마다 쌓인 메시지를 우선순위 순으로 kDispatchBudgetMicroseconds 동안 몰아서 처리하고,
+     * 화면 갱신과 로그 출력 같은 뒷정리는 그 뒤에 한 번만 한다
      */
     while (true) {
-        sprintf(str, "%010u", count);
-        FillRectangle(*(main_window->Writer()), {24, 28}, {8 * 10, 16}, {0xc6, 0xc6, 0xc6});
-        WriteString(*(main_window->Writer()), {24, 28}, str, {0, 0, 0});
-        layer_manager->Draw(main_window_layer_id);
+        const uint64_t budget_end = ReadTSC() + dispatch_budget;
+        Message msg;
+        while (main_queue.Pop(msg)) {
+            DispatchMessage(msg);
+            if (ReadTSC() >= budget_end) {
+                break;
+            }
+        }
 
-        __asm__("cli");     // critical section start
-        count = timer_manager->CurrentTick();
+        const unsigned long tick = timer_manager->CurrentTick();
+        if (const unsigned long msec = TicksToMilliseconds(tick); !count_drawn || msec != count) {
+            count = msec;
+            count_drawn = true;
+            FormatTo(str, sizeof(str), "%010lu", count);
+            FillRectangle(*(main_window->Writer()), {24, 28}, {8 * 10, 16}, {0xc6, 0xc6, 0xc6});
+            WriteString(*(main_window->Writer()), {24, 28}, str, {0, 0, 0});
+            layer_manager->Draw(main_window_layer_id);
+        }
+        FlushLog();
 
-        if (main_queue->empty()) {
-             __asm__("sti\n\thlt");
-            continue;
+        if (const auto dropped = main_queue.TotalDropped(); dropped != reported_drops) {
+            Log(kWarn, "main_queue overflow: %lu messages dropped\n", dropped - reported_drops);
+            reported_drops = dropped;
         }
 
-        Message msg = main_queue->front();
-        main_queue->pop_front();
-        __asm__("sti");     // critical section end
+        // 회수 작업은 인터럽트를 허용한 채로 메인 루프에서만 수행한다
+        CheckMemoryPressure(tick);
 
-        switch (msg.type) {
-            case Message::kNull:
-                break;
-            case Message::kInterruptXHCI:
-                usb::xhci::ProcessEvents();
-                break;
-            case Message::kTimerTimeout:
-                printk("Timer: timeout = %lu, value = %d\n",
-                       msg.arg.timer.timeout, msg.arg.timer.value);
-                if (msg.arg.timer.value > 0) {
-                    timer_manager->AddTimer(
-                            Timer(msg.arg.timer.timeout + 100, msg.arg.timer.value + 1));
-                }
-                break;
-            default:
-                Log(kError, "Unknown message type: %d\n", msg.type);
+        if (!main_queue.Empty()) {
+            continue;   // 예산을 다 써서 남은 메시지
+        }
+        // 할 일이 없는 동안 0으로 채운 프레임을 미리 만들어 둔다
+        if (ZeroPoolNeedsRefill() && !UnderMemoryPressure()) {
+            RefillZeroPool(kIdleZeroFrames);
+            continue;
         }
+        IdleWait(main_queue);
     }
 }
 
@@ -1,122 +1,788 @@
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include "memory_manager.hpp"
 #include "logger.hpp"
+#include "memstat.hpp"
+#include "paging.hpp"
 
-BitmapMemoryManager::BitmapMemoryManager()
-    : alloc_map_{}, range_begin_{FrameID{0}}, range_end_{FrameID{kFrameCount}} {}
+namespace {
+    /** @brief 커널이 아이덴티티 매핑할 수 있는 프레임 수. kNormal 존의 끝 */
+    const size_t kIdentityMappedFrames = kIdentityMapLimit / kBytesPerFrame;
 
-WithError<FrameID> BitmapMemoryManager::Allocate(size_t num_frames) {
-    size_t start_frame_id = range_begin_.ID();
-    while (true) {
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    size_t LineCount(size_t num_bits, size_t bits_per_line) {
+        return (num_bits + bits_per_line - 1) / bits_per_line;
+    }
+}
+
+size_t FindFrameExtents(const MemoryMap& memory_map,
+                        std::array<FrameExtent, kMaxFrameExtents>& extents) {
+    size_t num_extents = 0;
+    const auto memory_map_base = reinterpret_cast<uintptr_t>(memory_map.buffer);
+    for (uintptr_t iter = memory_map_base;
+         iter < memory_map_base + memory_map.map_size;
+         iter += memory_map.descriptor_size) {
+        auto desc = reinterpret_cast<const MemoryDescriptor*>(iter);
+        if (!IsAvailable(static_cast<MemoryType>(desc->type))) {
+            continue;
+        }
+
+        const size_t begin = desc->physical_start / kBytesPerFrame;
+        const size_t end = begin + desc->number_of_pages * kUEFIPageSize / kBytesPerFrame;
+
+        // UEFI는 메모리 맵의 정렬을 보장하지 않으므로 시작 주소 순서를 유지하며 끼워 넣는다.
+        // i는 kMinFrameHole 이상 떨어져 앞에 놓이는 익스텐트들 바로 뒤의 위치
         size_t i = 0;
-        for (; i < num_frames; ++i) {
-            if (start_frame_id + i >= range_end_.ID()) {
-                return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+        while (i < num_extents && extents[i].end + kMinFrameHole <= begin) {
+            ++i;
+        }
+
+        if (i < num_extents && extents[i].begin < end + kMinFrameHole) {
+            // 가까운 익스텐트에 합치고, 늘어난 끝에 닿는 뒤쪽 익스텐트도 합친다
+            auto& extent = extents[i];
+            extent.begin = std::min(extent.begin, begin);
+            extent.end = std::max(extent.end, end);
+            while (i + 1 < num_extents && extents[i + 1].begin < extent.end + kMinFrameHole) {
+                extent.end = std::max(extent.end, extents[i + 1].end);
+                std::copy(&extents[i + 2], &extents[num_extents], &extents[i + 1]);
+                --num_extents;
             }
-            if (GetBit(FrameID{start_frame_id + i})) {
+        } else if (num_extents < kMaxFrameExtents) {
+            std::copy_backward(&extents[i], &extents[num_extents], &extents[num_extents + 1]);
+            extents[i] = {begin, end};
+            ++num_extents;
+        } else if (i == num_extents || (i > 0 && begin - extents[i - 1].end < extents[i].begin - end)) {
+            // 자리가 없으면 구멍을 포함해 더 가까운 이웃으로 늘린다
+            extents[i - 1].end = end;
+        } else {
+            extents[i].begin = begin;
+        }
+    }
+    return num_extents;
+}
+
+FrameID ZoneBegin(MemoryZone zone) {
+    switch (zone) {
+        case MemoryZone::kDMA32: return FrameID{0};
+        case MemoryZone::kNormal: return ZoneEnd(MemoryZone::kDMA32);
+        case MemoryZone::kHigh: return ZoneEnd(MemoryZone::kNormal);
+    }
+    return FrameID{0};
+}
+
+FrameID ZoneEnd(MemoryZone zone) {
+    switch (zone) {
+        case MemoryZone::kDMA32: return FrameID{4_GiB / kBytesPerFrame};
+        case MemoryZone::kNormal: return FrameID{kIdentityMappedFrames};
+        case MemoryZone::kHigh: return kNullFrame;
+    }
+    return FrameID{0};
+}
+
+MemoryZone ZoneOf(FrameID frame) {
+    if (frame.ID() < ZoneEnd(MemoryZone::kDMA32).ID()) {
+        return MemoryZone::kDMA32;
+    } else if (frame.ID() < ZoneEnd(MemoryZone::kNormal).ID()) {
+        return MemoryZone::kNormal;
+    }
+    return MemoryZone::kHigh;
+}
+
+namespace {
+    using MapLineType = BitmapMemoryManager::MapLineType;
+    constexpr size_t kBitsPerMapLine = BitmapMemoryManager::kBitsPerMapLine;
+
+    /** @brief 한 요소 안의 [begin_bit, end_bit) 비트가 1인 마스크 */
+    MapLineType LineMask(size_t begin_bit, size_t end_bit) {
+        const MapLineType upper = end_bit == kBitsPerMapLine
+            ? ~MapLineType{0} : (MapLineType{1} << end_bit) - 1;
+        return upper & ~((MapLineType{1} << begin_bit) - 1);
+    }
+
+    void ApplyMask(MapLineType& line, MapLineType mask, bool value) {
+        if (value) {
+            line |= mask;
+        } else {
+            line &= ~mask;
+        }
+    }
+
+    /** @brief 비트맵 map의 [begin, end) 비트를 value로 채운다. 양 끝 이외의 요소는 통째로 쓴다. */
+    void FillBits(MapLineType* map, size_t begin, size_t end, bool value) {
+        const size_t first_line = begin / kBitsPerMapLine;
+        const size_t last_line = (end - 1) / kBitsPerMapLine;
+        const size_t last_bit_end = (end - 1) % kBitsPerMapLine + 1;
+
+        if (first_line == last_line) {
+            ApplyMask(map[first_line], LineMask(begin % kBitsPerMapLine, last_bit_end), value);
+            return;
+        }
+        ApplyMask(map[first_line], LineMask(begin % kBitsPerMapLine, kBitsPerMapLine), value);
+        std::fill(map + first_line + 1, map + last_line, value ? ~MapLineType{0} : 0);
+        ApplyMask(map[last_line], LineMask(0, last_bit_end), value);
+    }
+}
+
+BitmapMemoryManager::BitmapMemoryManager()
+    : extents_{}, num_extents_{0},
+      range_begin_{FrameID{0}}, range_end_{FrameID{0}}, next_fit_{} {}
+
+size_t BitmapMemoryManager::MetadataBytes(const FrameExtent* extents, size_t num_extents) {
+    size_t lines = 0;
+    for (size_t i = 0; i < num_extents; ++i) {
+        const size_t begin = extents[i].begin / kBitsPerMapLine * kBitsPerMapLine;
+        const size_t alloc_lines = LineCount(extents[i].end - begin, kBitsPerMapLine);
+        lines += alloc_lines + LineCount(alloc_lines, kBitsPerMapLine);
+    }
+    return lines * sizeof(MapLineType);
+}
+
+void BitmapMemoryManager::Initialize(const FrameExtent* extents, size_t num_extents, void* metadata) {
+    auto lines = reinterpret_cast<MapLineType*>(metadata);
+    num_extents_ = num_extents;
+    for (size_t i = 0; i < num_extents; ++i) {
+        auto& extent = extents_[i];
+        extent.begin = extents[i].begin / kBitsPerMapLine * kBitsPerMapLine;
+        extent.end = extents[i].end;
+
+        const size_t alloc_lines = LineCount(extent.end - extent.begin, kBitsPerMapLine);
+        const size_t full_lines = LineCount(alloc_lines, kBitsPerMapLine);
+        extent.alloc_map = lines;
+        extent.full_map = lines + alloc_lines;
+        std::fill(lines, lines + alloc_lines + full_lines, ~MapLineType{0});
+        lines += alloc_lines + full_lines;
+    }
+}
+
+WithError<FrameID> BitmapMemoryManager::Allocate(size_t num_frames) {
+    for (auto zone : kDefaultMemoryZones) {
+        auto result = Allocate(num_frames, zone, 1);
+        if (!result.error) {
+            return result;
+        }
+    }
+    return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+}
+
+WithError<FrameID> BitmapMemoryManager::Allocate(size_t num_frames, MemoryZone zone, size_t alignment) {
+    const size_t begin = std::max(range_begin_.ID(), ZoneBegin(zone).ID());
+    const size_t end = std::min(range_end_.ID(), ZoneEnd(zone).ID());
+    if (begin >= end) {
+        return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+    }
+
+    auto& next_fit = next_fit_[static_cast<size_t>(zone)];
+    size_t hint = next_fit;
+    if (hint < begin || end <= hint) {
+        hint = begin;
+    }
+
+    size_t start_frame_id = FindFreeRun(hint, end, num_frames, alignment);
+    if (start_frame_id == end) {
+        // 범위의 처음으로 돌아간다. hint를 가로지르는 빈 공간도 찾을 수 있도록 끝을 늘린다.
+        const size_t wrap_end = std::min(hint + num_frames, end);
+        start_frame_id = FindFreeRun(begin, wrap_end, num_frames, alignment);
+        if (start_frame_id == wrap_end) {
+            return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+        }
+    }
+
+    SetBits(start_frame_id, start_frame_id + num_frames, true);
+    next_fit = start_frame_id + num_frames;
+    return {
+        FrameID{start_frame_id},
+        MAKE_ERROR(Error::kSuccess),
+    };
+}
+
+Error BitmapMemoryManager::AllocateAt(FrameID start_frame, size_t num_frames) {
+    const size_t begin = start_frame.ID();
+    const size_t end = begin + num_frames;
+    if (begin < range_begin_.ID() || range_end_.ID() < end) {
+        return MAKE_ERROR(Error::kNoEnoughMemory);
+    }
+
+    for (size_t i = 0; i < num_extents_; ++i) {
+        const auto& extent = extents_[i];
+        if (extent.begin <= begin && end <= extent.end) {
+            if (FindUsed(extent, begin, end) != end) {
                 break;
             }
+            SetBits(begin, end, true);
+            return MAKE_ERROR(Error::kSuccess);
         }
-        if (i == num_frames) {
-            MarkAllocated(FrameID{start_frame_id}, num_frames);
-                return {
-                    FrameID{start_frame_id},
-                    MAKE_ERROR(Error::kSuccess),
-            };
-        }
-        start_frame_id += i + 1;
     }
+    return MAKE_ERROR(Error::kNoEnoughMemory);
 }
 
 Error BitmapMemoryManager::Free(FrameID start_frame, size_t num_frames) {
-    for (size_t i = 0; i < num_frames; ++i) {
-        SetBit(FrameID{start_frame.ID() + i}, false);
-    }
+    SetBits(start_frame.ID(), start_frame.ID() + num_frames, false);
     return MAKE_ERROR(Error::kSuccess);
 }
 
 void BitmapMemoryManager::MarkAllocated(FrameID start_frame, size_t num_frames) {
-    for (size_t i = 0; i < num_frames; ++i) {
-        SetBit(FrameID{start_frame.ID() + i}, true);
+    SetBits(start_frame.ID(), start_frame.ID() + num_frames, true);
+}
+
+size_t BitmapMemoryManager::CountFreeFrames(MemoryZone zone) const {
+    const size_t zone_begin = std::max(range_begin_.ID(), ZoneBegin(zone).ID());
+    const size_t zone_end = std::min(range_end_.ID(), ZoneEnd(zone).ID());
+
+    size_t count = 0;
+    for (size_t i = 0; i < num_extents_; ++i) {
+        const auto& extent = extents_[i];
+        const size_t end = std::min(zone_end, extent.end);
+        for (size_t frame = std::max(zone_begin, extent.begin); frame < end; ) {
+            const size_t bit = frame % kBitsPerMapLine;
+            const size_t bit_end = std::min(kBitsPerMapLine, bit + (end - frame));
+            const auto line = extent.alloc_map[(frame - extent.begin) / kBitsPerMapLine];
+            count += __builtin_popcountl(~line & LineMask(bit, bit_end));
+            frame += bit_end - bit;
+        }
     }
+    return count;
+}
+
+BitmapMemoryManager::Stats BitmapMemoryManager::GetStats() const {
+    Stats stats{0, 0, 0};
+    for (size_t i = 0; i < num_extents_; ++i) {
+        const auto& extent = extents_[i];
+        const size_t begin = std::max(range_begin_.ID(), extent.begin);
+        const size_t end = std::min(range_end_.ID(), extent.end);
+        for (size_t run = FindFree(extent, begin, end); run < end; ) {
+            const size_t run_end = FindUsed(extent, run, end);
+            ++stats.free_runs;
+            stats.free_frames += run_end - run;
+            stats.largest_free_run = std::max(stats.largest_free_run, run_end - run);
+            run = FindFree(extent, run_end, end);
+        }
+    }
+    return stats;
 }
 
 void BitmapMemoryManager::SetMemoryRange(FrameID range_begin, FrameID range_end) {
     range_begin_ = range_begin;
     range_end_ = range_end;
+    next_fit_.fill(range_begin.ID());
+}
+
+void BitmapMemoryManager::SetBits(size_t begin, size_t end, bool allocated) {
+    for (size_t i = 0; i < num_extents_; ++i) {
+        auto& extent = extents_[i];
+        const size_t local_begin = std::max(begin, extent.begin) - extent.begin;
+        const size_t local_end = std::min(end, extent.end) - extent.begin;
+        if (begin >= extent.end || end <= extent.begin || local_begin >= local_end) {
+            continue;
+        }
+
+        FillBits(extent.alloc_map, local_begin, local_end, allocated);
+
+        const size_t first_line = local_begin / kBitsPerMapLine;
+        const size_t last_line = (local_end - 1) / kBitsPerMapLine;
+        if (first_line + 1 < last_line) {
+            FillBits(extent.full_map, first_line + 1, last_line, allocated);
+        }
+        for (auto line : {first_line, last_line}) {
+            ApplyMask(extent.full_map[line / kBitsPerMapLine],
+                      MapLineType{1} << (line % kBitsPerMapLine),
+                      extent.alloc_map[line] == ~MapLineType{0});
+        }
+    }
+}
+
+size_t BitmapMemoryManager::FindFree(const Extent& extent, size_t begin, size_t end) const {
+    if (begin >= end) {
+        return end;
+    }
+
+    const size_t local_end = end - extent.begin;
+    size_t line = (begin - extent.begin) / kBitsPerMapLine;
+    MapLineType free_bits =
+        ~extent.alloc_map[line] & LineMask(begin % kBitsPerMapLine, kBitsPerMapLine);
+    while (free_bits == 0) {
+        // full_map 을 보고 가득 찬 요소를 64개 단위로 건너뛴다
+        ++line;
+        MapLineType not_full = 0;
+        while (line * kBitsPerMapLine < local_end) {
+            not_full = ~extent.full_map[line / kBitsPerMapLine] &
+                LineMask(line % kBitsPerMapLine, kBitsPerMapLine);
+            if (not_full) {
+                break;
+            }
+            line = (line / kBitsPerMapLine + 1) * kBitsPerMapLine;
+        }
+        if (line * kBitsPerMapLine >= local_end) {
+            return end;
+        }
+        line = line / kBitsPerMapLine * kBitsPerMapLine + __builtin_ctzl(not_full);
+        free_bits = ~extent.alloc_map[line];
+    }
+    return std::min(extent.begin + line * kBitsPerMapLine + __builtin_ctzl(free_bits), end);
+}
+
+size_t BitmapMemoryManager::FindUsed(const Extent& extent, size_t begin, size_t end) const {
+    if (begin >= end) {
+        return end;
+    }
+
+    const size_t local_end = end - extent.begin;
+    size_t line = (begin - extent.begin) / kBitsPerMapLine;
+    MapLineType used_bits =
+        extent.alloc_map[line] & LineMask(begin % kBitsPerMapLine, kBitsPerMapLine);
+    while (used_bits == 0) {
+        ++line;
+        if (line * kBitsPerMapLine >= local_end) {
+            return end;
+        }
+        used_bits = extent.alloc_map[line];
+    }
+    return std::min(extent.begin + line * kBitsPerMapLine + __builtin_ctzl(used_bits), end);
+}
+
+size_t BitmapMemoryManager::FindFreeRun(size_t begin, size_t end,
+                                        size_t num_frames, size_t alignment) const {
+    // 익스텐트 사이는 구멍이므로 연속된 빈 프레임은 한 익스텐트 안에서만 찾는다
+    for (size_t i = 0; i < num_extents_; ++i) {
+        const auto& extent = extents_[i];
+        const size_t extent_end = std::min(end, extent.end);
+        size_t start = AlignUp(FindFree(extent, std::max(begin, extent.begin), extent_end), alignment);
+        while (start < extent_end && num_frames <= extent_end - start) {
+            const size_t used = FindUsed(extent, start, start + num_frames);
+            if (used == start + num_frames) {
+                return start;
+            }
+            start = AlignUp(FindFree(extent, used, extent_end), alignment);
+        }
+    }
+    return end;
+}
+
+namespace {
+    /** @brief 2^order >= num_frames 를 만족하는 최소의 order */
+    unsigned int OrderOf(size_t num_frames) {
+        return num_frames <= 1 ? 0 : 8 * sizeof(unsigned long) - __builtin_clzl(num_frames - 1);
+    }
+}
+
+BuddyMemoryManager::BuddyMemoryManager()
+    : extents_{}, num_extents_{0}, free_lists_{}, free_counts_{}, zone_free_frames_{},
+      range_begin_{FrameID{0}}, range_end_{FrameID{0}} {}
+
+size_t BuddyMemoryManager::MetadataBytes(const FrameExtent* extents, size_t num_extents) {
+    size_t lines = 0;
+    for (size_t i = 0; i < num_extents; ++i) {
+        lines += LineCount(extents[i].end - extents[i].begin, kBitsPerMapLine);
+    }
+    return lines * sizeof(MapLineType);
+}
+
+void BuddyMemoryManager::Initialize(const FrameExtent* extents, size_t num_extents, void* metadata) {
+    auto lines = reinterpret_cast<MapLineType*>(metadata);
+    num_extents_ = num_extents;
+    for (size_t i = 0; i < num_extents; ++i) {
+        auto& extent = extents_[i];
+        extent.begin = extents[i].begin;
+        extent.end = extents[i].end;
+        extent.head_map = lines;
+
+        const size_t num_lines = LineCount(extent.end - extent.begin, kBitsPerMapLine);
+        std::fill(lines, lines + num_lines, 0);
+        lines += num_lines;
+    }
+}
+
+WithError<FrameID> BuddyMemoryManager::Allocate(size_t num_frames) {
+    for (auto zone : kDefaultMemoryZones) {
+        auto result = Allocate(num_frames, zone, 1);
+        if (!result.error) {
+            return result;
+        }
+    }
+    return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+}
+
+WithError<FrameID> BuddyMemoryManager::Allocate(size_t num_frames, MemoryZone zone, size_t alignment) {
+    // 차수 o의 블록은 2^o 프레임 경계에 놓이므로 정렬 요구는 차수를 올려 만족시킨다
+    const unsigned int order = std::max(OrderOf(num_frames), OrderOf(alignment));
+    if (order > kMaxOrder) {
+        return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+    }
+
+    const auto& free_lists = free_lists_[static_cast<size_t>(zone)];
+    unsigned int block_order = order;
+    while (block_order <= kMaxOrder && free_lists[block_order] == nullptr) {
+        ++block_order;
+    }
+    if (block_order > kMaxOrder) {
+        return {kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+    }
+
+    const size_t head = reinterpret_cast<uintptr_t>(free_lists[block_order]) / kBytesPerFrame;
+    RemoveFreeBlock(head, block_order);
+    while (block_order > order) {
+        --block_order;
+        PushFreeBlock(head + (size_t{1} << block_order), block_order);
+    }
+    ReleaseRange(head + num_frames, head + (size_t{1} << order));
+
+    return {
+        FrameID{head},
+        MAKE_ERROR(Error::kSuccess),
+    };
+}
+
+Error BuddyMemoryManager::AllocateAt(FrameID start_frame, size_t num_frames) {
+    const size_t end = start_frame.ID() + num_frames;
+    if (start_frame.ID() < range_begin_.ID() || range_end_.ID() < end) {
+        return MAKE_ERROR(Error::kNoEnoughMemory);
+    }
+
+    // 범위 전체가 빈 블록들로 덮여 있는지 확인한 뒤 잘라 낸다
+    for (size_t frame = start_frame.ID(); frame < end; ) {
+        size_t head;
+        unsigned int order;
+        if (!FindFreeBlock(frame, head, order)) {
+            return MAKE_ERROR(Error::kNoEnoughMemory);
+        }
+        frame = head + (size_t{1} << order);
+    }
+    MarkAllocated(start_frame, num_frames);
+    return MAKE_ERROR(Error::kSuccess);
+}
+
+Error BuddyMemoryManager::Free(FrameID start_frame, size_t num_frames) {
+    ReleaseRange(start_frame.ID(), start_frame.ID() + num_frames);
+    return MAKE_ERROR(Error::kSuccess);
+}
+
+void BuddyMemoryManager::MarkAllocated(FrameID start_frame, size_t num_frames) {
+    const size_t end = std::min(start_frame.ID() + num_frames, range_end_.ID());
+    size_t frame = std::max(start_frame.ID(), range_begin_.ID());
+    while (frame < end) {
+        size_t head;
+        unsigned int order;
+        if (!FindFreeBlock(frame, head, order)) {
+            frame = FindFreeHead(frame + 1, end);
+            continue;
+        }
+
+        // 빈 블록을 떼어 내고 [frame, end) 바깥 부분만 다시 해제한다
+        const size_t block_end = head + (size_t{1} << order);
+        RemoveFreeBlock(head, order);
+        ReleaseRange(head, frame);
+        ReleaseRange(std::min(end, block_end), block_end);
+        frame = block_end;
+    }
+}
+
+size_t BuddyMemoryManager::CountFreeFrames(MemoryZone zone) const {
+    return zone_free_frames_[static_cast<size_t>(zone)];
+}
+
+void BuddyMemoryManager::SetMemoryRange(FrameID range_begin, FrameID range_end) {
+    range_begin_ = range_begin;
+    range_end_ = FrameID{std::min(range_end.ID(), kIdentityMappedFrames)};
+}
+
+BuddyMemoryManager::Stats BuddyMemoryManager::GetStats() const {
+    Stats stats{0, zone_free_frames_, free_counts_, -1};
+    for (auto frames : zone_free_frames_) {
+        stats.free_frames += frames;
+    }
+    for (int order = kMaxOrder; order >= 0; --order) {
+        if (free_counts_[order] > 0) {
+            stats.largest_free_order = order;
+            break;
+        }
+    }
+    return stats;
+}
+
+const BuddyMemoryManager::Extent* BuddyMemoryManager::ExtentOf(size_t frame) const {
+    for (size_t i = 0; i < num_extents_; ++i) {
+        if (extents_[i].begin <= frame && frame < extents_[i].end) {
+            return &extents_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool BuddyMemoryManager::IsFreeHead(size_t frame) const {
+    const auto extent = ExtentOf(frame);
+    if (extent == nullptr) {
+        return false;
+    }
+    const size_t bit = frame - extent->begin;
+    return (extent->head_map[bit / kBitsPerMapLine] >> (bit % kBitsPerMapLine)) & 1;
+}
+
+void BuddyMemoryManager::SetFreeHead(size_t frame, bool head) {
+    const auto extent = ExtentOf(frame);
+    const size_t bit = frame - extent->begin;
+    ApplyMask(extent->head_map[bit / kBitsPerMapLine], MapLineType{1} << (bit % kBitsPerMapLine), head);
 }
 
-bool BitmapMemoryManager::GetBit(FrameID frame) const {
-    auto line_index = frame.ID() / kBitsPerMapLine;
-    auto bit_index = frame.ID() % kBitsPerMapLine;
+size_t BuddyMemoryManager::FindFreeHead(size_t begin, size_t end) const {
+    for (size_t i = 0; i < num_extents_; ++i) {
+        const auto& extent = extents_[i];
+        const size_t local_begin = std::max(begin, extent.begin) - extent.begin;
+        const size_t local_end = std::min(end, extent.end) - extent.begin;
+        if (begin >= extent.end || end <= extent.begin || local_begin >= local_end) {
+            continue;
+        }
 
-    return (alloc_map_[line_index] & (static_cast<MapLineType>(1) << bit_index)) != 0;
+        size_t line = local_begin / kBitsPerMapLine;
+        MapLineType heads =
+            extent.head_map[line] & (~MapLineType{0} << (local_begin % kBitsPerMapLine));
+        while (heads == 0 && (line + 1) * kBitsPerMapLine < local_end) {
+            heads = extent.head_map[++line];
+        }
+        if (heads != 0) {
+            return std::min(extent.begin + line * kBitsPerMapLine + __builtin_ctzl(heads), end);
+        }
+    }
+    return end;
+}
+
+bool BuddyMemoryManager::FindFreeBlock(size_t frame, size_t& head, unsigned int& order) const {
+    for (unsigned int o = 0; o <= kMaxOrder; ++o) {
+        const size_t candidate = frame & ~((size_t{1} << o) - 1);
+        if (!IsFreeHead(candidate)) {
+            continue;
+        }
+        const auto block = reinterpret_cast<const FreeBlock*>(FrameID{candidate}.Frame());
+        if (frame < candidate + (size_t{1} << block->order)) {
+            head = candidate;
+            order = block->order;
+            return true;
+        }
+    }
+    return false;
 }
 
-void BitmapMemoryManager::SetBit(FrameID frame, bool allocated) {
-    auto line_index = frame.ID() / kBitsPerMapLine;
-    auto bit_index = frame.ID() % kBitsPerMapLine;
+void BuddyMemoryManager::PushFreeBlock(size_t frame, unsigned int order) {
+    const auto zone = static_cast<size_t>(ZoneOf(FrameID{frame}));
+    auto block = reinterpret_cast<FreeBlock*>(FrameID{frame}.Frame());
+    block->next = free_lists_[zone][order];
+    block->prev = nullptr;
+    block->order = order;
+    if (block->next) {
+        block->next->prev = block;
+    }
+    free_lists_[zone][order] = block;
 
-    if (allocated) {
-        alloc_map_[line_index] |= (static_cast<MapLineType>(1) << bit_index);
+    SetFreeHead(frame, true);
+    ++free_counts_[order];
+    zone_free_frames_[zone] += size_t{1} << order;
+}
+
+void BuddyMemoryManager::RemoveFreeBlock(size_t frame, unsigned int order) {
+    const auto zone = static_cast<size_t>(ZoneOf(FrameID{frame}));
+    auto block = reinterpret_cast<FreeBlock*>(FrameID{frame}.Frame());
+    if (block->prev) {
+        block->prev->next = block->next;
     } else {
-        alloc_map_[line_index] &= ~(static_cast<MapLineType>(1) << bit_index);
+        free_lists_[zone][order] = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+
+    SetFreeHead(frame, false);
+    --free_counts_[order];
+    zone_free_frames_[zone] -= size_t{1} << order;
+}
+
+void BuddyMemoryManager::ReleaseBlock(size_t frame, unsigned int order) {
+    while (order < kMaxOrder) {
+        const size_t buddy = frame ^ (size_t{1} << order);
+        if (!IsFreeHead(buddy) ||
+            reinterpret_cast<const FreeBlock*>(FrameID{buddy}.Frame())->order != order) {
+            break;
+        }
+        RemoveFreeBlock(buddy, order);
+        frame &= ~(size_t{1} << order);
+        ++order;
+    }
+    PushFreeBlock(frame, order);
+}
+
+void BuddyMemoryManager::ReleaseRange(size_t begin, size_t end) {
+    begin = std::max(begin, range_begin_.ID());
+    end = std::min(end, range_end_.ID());
+    while (begin < end) {
+        unsigned int order = begin == 0 ? kMaxOrder
+            : std::min<unsigned int>(__builtin_ctzl(begin), kMaxOrder);
+        while ((size_t{1} << order) > end - begin) {
+            --order;
+        }
+        ReleaseBlock(begin, order);
+        begin += size_t{1} << order;
     }
 }
 
 extern "C" caddr_t program_break, program_break_end;
 
+MemoryManager* memory_manager;
+
 namespace {
-    char memory_manager_buf[sizeof(BitmapMemoryManager)];
-    BitmapMemoryManager* memory_manager;
+    char memory_manager_buf[sizeof(MemoryManager)];
 
-    Error InitializeHeap() {
-        const int kHeapFrames = 64 * 512;
-        const auto heap_start = memory_manager->Allocate(kHeapFrames);
-        if (heap_start.error) {
-            return heap_start.error;
+    /** @brief 힙을 늘릴 때 프레임 할당자에서 한 번에 가져오는 최소 프레임 수(2MiB) */
+    const size_t kHeapChunkFrames = 512;
+
+    /** @brief break 뒤에서 프레임 경계부터 program_break_end까지를 돌려준다. */
+    void ReleaseHeapTail() {
+        const size_t begin = LineCount(reinterpret_cast<uintptr_t>(program_break), kBytesPerFrame);
+        const size_t end = reinterpret_cast<uintptr_t>(program_break_end) / kBytesPerFrame;
+        if (begin < end) {
+            memory_manager->Free(FrameID{begin}, end - begin);
+            AccountFrames(FrameOwner::kHeap, -static_cast<long>(end - begin));
+            program_break_end = reinterpret_cast<caddr_t>(FrameID{begin}.Frame());
         }
+    }
+}
+
+// malloc은 kmalloc.cpp가 맡으므로 sbrk 힙은 처음 쓰일 때 만든다
+extern "C" int GrowHeap(size_t bytes) {
+    const size_t shortage = program_break + bytes - program_break_end;
+    const size_t extend_frames = std::max(kHeapChunkFrames, LineCount(shortage, kBytesPerFrame));
+    const FrameID heap_end{reinterpret_cast<uintptr_t>(program_break_end) / kBytesPerFrame};
+    if (!memory_manager->AllocateAt(heap_end, extend_frames)) {
+        program_break_end += extend_frames * kBytesPerFrame;
+        AccountFrames(FrameOwner::kHeap, extend_frames);
+        return 0;
+    }
 
-        program_break = reinterpret_cast<caddr_t>(heap_start.value.ID() * kBytesPerFrame);
-        program_break_end = program_break + kHeapFrames * kBytesPerFrame;
-        return MAKE_ERROR(Error::kSuccess);
+    // 힙이 아직 없거나 뒤가 막혀 있으면 새 청크로 옮긴다
+    const size_t chunk_frames = std::max(kHeapChunkFrames, LineCount(bytes, kBytesPerFrame));
+    const auto chunk = memory_manager->Allocate(chunk_frames);
+    if (chunk.error) {
+        return -1;
     }
+    ReleaseHeapTail();
+    AccountFrames(FrameOwner::kHeap, chunk_frames);
+    Log(kDebug, "heap moved to new chunk %p (%lu frames)\n", chunk.value.Frame(), chunk_frames);
+
+    program_break = reinterpret_cast<caddr_t>(chunk.value.Frame());
+    program_break_end = program_break + chunk_frames * kBytesPerFrame;
+    return 0;
+}
+
+extern "C" void ShrinkHeap(void) {
+    ReleaseHeapTail();
 }
 
 void InitializeMemoryManager(const MemoryMap& memory_map) {
-    ::memory_manager = new(memory_manager_buf) BitmapMemoryManager;
+    ::memory_manager = new(memory_manager_buf) MemoryManager;
 
+    std::array<FrameExtent, kMaxFrameExtents> extents;
+    const size_t num_extents = FindFrameExtents(memory_map, extents);
+    if (num_extents == 0) {
+        Log(kError, "no available memory\n");
+        exit(1);
+    }
+
+    // 관리 메타데이터는 충분한 크기의 첫 번째 일반 메모리(kEfiConventionalMemory) 영역 앞부분에 둔다
+    const size_t metadata_frames =
+        LineCount(MemoryManager::MetadataBytes(extents.data(), num_extents), kBytesPerFrame);
+    size_t metadata_begin = 0;
     const auto memory_map_base = reinterpret_cast<uintptr_t>(memory_map.buffer);
-    uintptr_t available_end = 0;
-    for (uintptr_t iter = memory_map_base;
-         iter < memory_map_base + memory_map.map_size;
-         iter += memory_map.descriptor_size) {
+    const auto memory_map_end = memory_map_base + memory_map.map_size;
+    for (uintptr_t iter = memory_map_base; iter < memory_map_end; iter += memory_map.descriptor_size) {
+        auto desc = reinterpret_cast<const MemoryDescriptor*>(iter);
+        const size_t begin = std::max<size_t>(desc->physical_start / kBytesPerFrame, 1);
+        const size_t end = (desc->physical_start + desc->number_of_pages * kUEFIPageSize) / kBytesPerFrame;
+        if (static_cast<MemoryType>(desc->type) == MemoryType::kEfiConventionalMemory &&
+            begin + metadata_frames <= std::min(end, kIdentityMappedFrames)) {
+            metadata_begin = begin;
+            break;
+        }
+    }
+    if (metadata_begin == 0) {
+        Log(kError, "no room for memory manager metadata (%lu frames)\n", metadata_frames);
+        exit(1);
+    }
+    const size_t metadata_end = metadata_begin + metadata_frames;
+    memory_manager->Initialize(extents.data(), num_extents, FrameID{metadata_begin}.Frame());
+    memory_manager->SetMemoryRange(FrameID{1}, FrameID{extents[num_extents - 1].end});
+    AccountFrames(FrameOwner::kMetadata, metadata_frames);
+    Log(kInfo, "Memory manager: %lu extents, metadata %p (%lu frames)\n",
+        num_extents, FrameID{metadata_begin}.Frame(), metadata_frames);
+
+    // 모든 프레임이 사용 중인 상태에서 시작해 메타데이터를 뺀 일반 메모리만 해제한다.
+    // 부트 서비스 영역에는 아직 UEFI의 페이지 테이블과 로더가 넘겨준 메모리 맵(로더의 스택)이 있으므로
+    // 해제하지 않는다. 반복 중에 메모리 맵이 덮어써지지 않도록 ReleaseBootServicesMemory에서 따로 해제한다.
+    uintptr_t previous_end = 0;
+    for (uintptr_t iter = memory_map_base; iter < memory_map_end; iter += memory_map.descriptor_size) {
         auto desc = reinterpret_cast<const MemoryDescriptor*>(iter);
-        if (available_end < desc->physical_start) {
-            memory_manager->MarkAllocated(
-                    FrameID{available_end / kBytesPerFrame},
-                    (desc->physical_start - available_end) / kBytesPerFrame);
-            Log(kInfo, "Page [N/A] : 0x%08x (%d pages)\n", desc->physical_start, desc->number_of_pages);
-        }
-
-        const auto physical_end =
-                desc->physical_start + desc->number_of_pages * kUEFIPageSize;
-        if (IsAvailable(static_cast<MemoryType>(desc->type))) {
-            available_end = physical_end;
-            Log(kInfo, "Page [Available] : 0x%08x (%d pages)\n", desc->physical_start, desc->number_of_pages);
+        if (previous_end < desc->physical_start) {
+            Log(kInfo, "Page [N/A] : 0x%08lx (%lu pages)\n",
+                previous_end, (desc->physical_start - previous_end) / kUEFIPageSize);
+        }
+        previous_end = desc->physical_start + desc->number_of_pages * kUEFIPageSize;
+
+        if (desc->type == MemoryType::kEfiConventionalMemory) {
+            const size_t begin = desc->physical_start / kBytesPerFrame;
+            const size_t end = previous_end / kBytesPerFrame;
+            if (begin < metadata_begin) {
+                memory_manager->Free(FrameID{begin}, std::min(end, metadata_begin) - begin);
+            }
+            if (metadata_end < end) {
+                const size_t free_begin = std::max(begin, metadata_end);
+                memory_manager->Free(FrameID{free_begin}, end - free_begin);
+            }
+            Log(kInfo, "Page [Available] : 0x%08lx (%lu pages)\n", desc->physical_start, desc->number_of_pages);
+        } else if (IsAvailable(static_cast<MemoryType>(desc->type))) {
+            Log(kInfo, "Page [BootServices] : 0x%08lx (%lu pages)\n", desc->physical_start, desc->number_of_pages);
         } else {
-            memory_manager->MarkAllocated(
-                    FrameID{desc->physical_start / kBytesPerFrame},
-                    desc->number_of_pages * kUEFIPageSize / kBytesPerFrame);
-            Log(kInfo, "Page [Reserved] : 0x%08x (%d pages)\n", desc->physical_start, desc->number_of_pages);
+            Log(kInfo, "Page [Reserved] : 0x%08lx (%lu pages)\n", desc->physical_start, desc->number_of_pages);
         }
     }
-    memory_manager->SetMemoryRange(FrameID{1}, FrameID{available_end / kBytesPerFrame});
 
-    if (auto err = InitializeHeap()) {
-        Log(kError, "failed to allocate pages: %s at %s:%d\n",
-            err.Name(), err.File(), err.Line());
-        exit(1);
+    Log(kInfo, "Memory zones: DMA32 %lu, Normal %lu, High %lu free frames\n",
+        memory_manager->CountFreeFrames(MemoryZone::kDMA32),
+        memory_manager->CountFreeFrames(MemoryZone::kNormal),
+        memory_manager->CountFreeFrames(MemoryZone::kHigh));
+
+#ifdef USE_BUDDY_ALLOCATOR
+    const auto stats = memory_manager->GetStats();
+    Log(kInfo, "Buddy allocator: %lu free frames, largest free block order %d\n",
+        stats.free_frames, stats.largest_free_order);
+    for (unsigned int order = 0; order <= BuddyMemoryManager::kMaxOrder; ++order) {
+        Log(kDebug, "  order %2u: %lu blocks\n", order, stats.free_blocks[order]);
     }
-}
\ No newline at end of file
+#endif
+}
+
+void ReleaseBootServicesMemory(const MemoryMap& memory_map) {
+    // MemoryMap 구조체와 버퍼 모두 부트 서비스 영역(로더의 스택)에 있으므로 복사한 뒤 해제한다
+    const size_t map_size = memory_map.map_size;
+    const size_t descriptor_size = memory_map.descriptor_size;
+    const auto buffer = reinterpret_cast<uint8_t*>(malloc(map_size));
+    if (buffer == nullptr) {
+        Log(kError, "failed to copy memory map\n");
+        return;
+    }
+    memcpy(buffer, memory_map.buffer, map_size);
+
+    size_t released_frames = 0;
+    for (size_t offset = 0; offset < map_size; offset += descriptor_size) {
+        auto desc = reinterpret_cast<const MemoryDescriptor*>(buffer + offset);
+        if (desc->type == MemoryType::kEfiBootServicesCode ||
+            desc->type == MemoryType::kEfiBootServicesData) {
+            const size_t frames = desc->number_of_pages * kUEFIPageSize / kBytesPerFrame;
+            memory_manager->Free(FrameID{desc->physical_start / kBytesPerFrame}, frames);
+            released_frames += frames;
+        }
+    }
+    free(buffer);
+    Log(kInfo, "Released %lu boot services frames\n", released_frames);
+}
@@ -35,31 +35,103 @@ public:
 
 static const FrameID kNullFrame{std::numeric_limits<size_t>::max()};
 
+/** @brief 물리 메모리 존.
+ * kDMA32는 32비트 DMA 장치가 접근할 수 있는 4GiB 미만,
+ * kNormal은 그 위로 커널이 아이덴티티 매핑한 범위까지, kHigh는 그보다 위의 영역이다.
+ * 존의 실제 범위는 메모리 맵에서 얻은 관리 범위와 이 경계의 교집합이다.
+ */
+enum class MemoryZone {
+    kDMA32,
+    kNormal,
+    kHigh,
+};
+
+const size_t kMemoryZoneCount = 3;
+/** @brief 존을 지정하지 않은 할당에서 시도하는 존의 순서. 저위 메모리는 DMA용으로 가능한 한 남겨 둔다. */
+const std::array<MemoryZone, 2> kDefaultMemoryZones{MemoryZone::kNormal, MemoryZone::kDMA32};
+
+/** @brief 존의 첫 프레임 */
+FrameID ZoneBegin(MemoryZone zone);
+/** @brief 존의 끝. 최종 프레임의 다음 프레임 */
+FrameID ZoneEnd(MemoryZone zone);
+/** @brief 프레임이 속한 존 */
+MemoryZone ZoneOf(FrameID frame);
+
+/** @brief 관리 메타데이터를 두는 연속된 프레임 범위 [begin, end).
+ * 메모리 맵의 사용 가능 영역을 덮으며, kMinFrameHole 이상의 구멍에서 나뉜다.
+ */
+struct FrameExtent {
+    size_t begin;
+    size_t end;
+};
+
+/** @brief 익스텐트의 최대 수. 넘치면 가장 가까운 익스텐트가 구멍을 포함해 늘어난다. */
+const size_t kMaxFrameExtents = 32;
+/** @brief 이 크기 이상의 구멍은 비트를 두지 않고 익스텐트를 나눈다. */
+const size_t kMinFrameHole = 1_GiB / kBytesPerFrame;
+
+/** @brief 메모리 맵에서 시작 주소 순으로 정렬된 익스텐트 목록을 만들고 그 수를 반환합니다.
+ * 메모리 맵의 서술자는 정렬되어 있지 않아도 됩니다.
+ */
+size_t FindFrameExtents(const MemoryMap& memory_map,
+                        std::array<FrameExtent, kMaxFrameExtents>& extents);
+
 /** @brief 비트 맵 배열을 사용하여 프레임 단위로 메모리를 관리하는 클래스.
  * 1 비트를 1 프레임에 대응시켜, 비트 맵에 의해 빈 프레임을 관리한다.
- * 배열 alloc_map의 각 비트는 프레임에 해당하며 0이면 비어 있고 1이면 사용 중입니다.
- * alloc_map[n] 의 m 비트째가 대응하는 물리 어드레스는 다음 식으로 구해진다:
- * kFrameBytes * (n * kBitsPerMapLine + m)
+ * 비트맵은 익스텐트마다 따로 두며, 각 비트는 0이면 비어 있고 1이면 사용 중입니다.
+ * 익스텐트 e의 alloc_map[n] 의 m 비트째가 대응하는 물리 어드레스는 다음 식으로 구해진다:
+ * kFrameBytes * (e.begin + n * kBitsPerMapLine + m)
+ *
+ * 탐색과 설정은 비트가 아닌 요소(kBitsPerMapLine 프레임) 단위로 수행한다.
+ * 요약 비트맵 full_map의 n 비트째는 alloc_map[n]이 모두 사용 중일 때 1이며,
+ * 할당 시 가득 찬 요소를 건너뛰는 데 사용한다.
  */
 class BitmapMemoryManager {
 public:
-    /** @brief 이 메모리 관리 클래스에서 취급할 수 있는 최대의 물리적 메모리량(바이트) */
-    static const auto kMaxPhysicalMemoryBytes{128_GiB};
-    /** @brief kMaxPhysicalMemoryBytes까지의 실제 메모리를 처리하는 데 필요한 프레임 수 */
-    static const auto kFrameCount{kMaxPhysicalMemoryBytes / kBytesPerFrame};
-
     /** @brief 비트맵 배열의 요소형 */
     using MapLineType = unsigned long;
     /** @brief 비트맵 배열의 한 요소의 비트 수 == 프레임 수 */
     static const size_t kBitsPerMapLine{8 * sizeof(MapLineType)};
 
-    /** @brief 인스턴스를 초기화합니다. */
+    /** @brief 단편화 통계 */
+    struct Stats {
+        /** @brief 빈 프레임의 총수 */
+        size_t free_frames;
+        /** @brief 연속된 빈 프레임 구간의 수 */
+        size_t free_runs;
+        /** @brief 가장 긴 빈 프레임 구간의 프레임 수 */
+        size_t largest_free_run;
+    };
+
+    /** @brief 인스턴스를 초기화합니다. Initialize 전에는 관리하는 프레임이 없습니다. */
     BitmapMemoryManager();
 
-    /** @brief 요청한 프레임 수의 공간을 확보하고 첫 번째 프레임 ID를 반환합니다. */
+    /** @brief 익스텐트들의 비트맵에 필요한 바이트 수 */
+    static size_t MetadataBytes(const FrameExtent* extents, size_t num_extents);
+    /** @brief metadata를 익스텐트별 비트맵으로 나누어 쓰고, 모든 프레임을 사용 중 상태로 초기화합니다.
+     *
+     * @param metadata MetadataBytes 바이트 이상의, 아이덴티티 매핑된 영역
+     */
+    void Initialize(const FrameExtent* extents, size_t num_extents, void* metadata);
+
+    /** @brief 요청한 프레임 수의 공간을 확보하고 첫 번째 프레임 ID를 반환합니다.
+     * DMA용 저위 메모리를 남겨 두기 위해 kNormal 존을 먼저 시도하고 모자라면 kDMA32 존을 사용한다.
+     */
     WithError<FrameID> Allocate(size_t num_frames);
+    /** @brief 지정한 존 안에서 alignment 프레임 경계에 맞춘 공간을 확보합니다.
+     * 존마다 직전 할당의 끝에서부터 탐색을 시작하고(next-fit), 존의 끝에 다다르면 처음으로 돌아간다.
+     *
+     * @param alignment 시작 프레임의 정렬 단위(프레임 수, 2의 거듭제곱)
+     */
+    WithError<FrameID> Allocate(size_t num_frames, MemoryZone zone, size_t alignment);
+    /** @brief start_frame부터 num_frames 개의 프레임을 확보합니다. 하나라도 사용 중이면 실패합니다. */
+    Error AllocateAt(FrameID start_frame, size_t num_frames);
     Error Free(FrameID start_frame, size_t num_frames);
     void MarkAllocated(FrameID start_frame, size_t num_frames);
+    /** @brief 존 안의 빈 프레임 수 */
+    size_t CountFreeFrames(MemoryZone zone) const;
+    /** @brief 비트맵 전체를 훑어 단편화 통계를 계산합니다. */
+    Stats GetStats() const;
 
     /** @brief 이 메모리 관리자가 처리 할 메모리 범위를 설정합니다.
      * 이 호출 이후 Allocate에 의한 메모리 할당은 설정된 범위 내에서만 수행됩니다.
@@ -70,14 +142,147 @@ public:
     void SetMemoryRange(FrameID range_begin, FrameID range_end);
 
 private:
-    std::array<MapLineType, kFrameCount / kBitsPerMapLine> alloc_map_;
+    struct Extent {
+        /** @brief 첫 프레임. kBitsPerMapLine의 배수 */
+        size_t begin;
+        size_t end;
+        MapLineType* alloc_map;
+        /** @brief alloc_map의 요소마다 1 비트. 요소의 모든 프레임이 사용 중이면 1 */
+        MapLineType* full_map;
+    };
+
+    std::array<Extent, kMaxFrameExtents> extents_;
+    size_t num_extents_;
     /** @brief 메모리 관리자가 처리하는 메모리 범위의 시작점. */
     FrameID range_begin_;
     /** @brief 메모리 관리자가 처리하는 메모리 범위의 끝점. 최종 프레임의 다음 프레임. */
     FrameID range_end_;
+    /** @brief 존마다 다음 Allocate가 탐색을 시작할 프레임. */
+    std::array<size_t, kMemoryZoneCount> next_fit_;
+
+    /** @brief [begin, end) 범위의 프레임을 한꺼번에 사용 중 또는 빈 상태로 설정합니다. */
+    void SetBits(size_t begin, size_t end, bool allocated);
+    /** @brief 익스텐트 안의 [begin, end) 에서 처음 나오는 빈 프레임. 없으면 end */
+    size_t FindFree(const Extent& extent, size_t begin, size_t end) const;
+    /** @brief 익스텐트 안의 [begin, end) 에서 처음 나오는 사용 중인 프레임. 없으면 end */
+    size_t FindUsed(const Extent& extent, size_t begin, size_t end) const;
+    /** @brief [begin, end) 에서 alignment 경계에서 시작하는 num_frames 개의 연속된 빈 프레임을 찾습니다. 없으면 end */
+    size_t FindFreeRun(size_t begin, size_t end, size_t num_frames, size_t alignment) const;
+};
+
+/** @brief 2의 거듭제곱 크기 블록의 빈 리스트로 프레임을 관리하는 버디 할당자.
+ * BitmapMemoryManager와 같은 인터페이스를 가지며 빌드 시 USE_BUDDY_ALLOCATOR로 선택한다.
+ * 빈 블록의 첫 프레임에 FreeBlock 헤더를 두어 차수별 이중 연결 리스트를 구성하므로,
+ * 관리 대상 프레임은 아이덴티티 매핑되어 있어야 한다.
+ * 할당과 해제는 O(log n)이며 해제 시 버디 블록이 비어 있으면 병합한다.
+ * 존 경계는 최대 블록 크기의 배수이므로 블록이 존을 걸치지 않으며, 빈 리스트는 존별로 둔다.
+ */
+class BuddyMemoryManager {
+public:
+    /** @brief 블록의 최대 차수. 가장 큰 블록은 2^kMaxOrder 프레임(1GiB) */
+    static const unsigned int kMaxOrder{18};
+
+    using MapLineType = unsigned long;
+    static const size_t kBitsPerMapLine{8 * sizeof(MapLineType)};
+
+    /** @brief 단편화 통계 */
+    struct Stats {
+        /** @brief 빈 프레임의 총수 */
+        size_t free_frames;
+        /** @brief 존별 빈 프레임 수 */
+        std::array<size_t, kMemoryZoneCount> zone_free_frames;
+        /** @brief 차수별 빈 블록 수 */
+        std::array<size_t, kMaxOrder + 1> free_blocks;
+        /** @brief 가장 큰 빈 블록의 차수. 빈 블록이 없으면 -1 */
+        int largest_free_order;
+    };
+
+    /** @brief 인스턴스를 초기화합니다. Initialize 전에는 관리하는 프레임이 없습니다. */
+    BuddyMemoryManager();
+
+    /** @brief 익스텐트들의 블록 선두 비트맵에 필요한 바이트 수 */
+    static size_t MetadataBytes(const FrameExtent* extents, size_t num_extents);
+    /** @brief metadata를 익스텐트별 비트맵으로 나누어 쓰고, 모든 프레임을 사용 중 상태로 초기화합니다. */
+    void Initialize(const FrameExtent* extents, size_t num_extents, void* metadata);
+
+    /** @brief 요청한 프레임 수의 공간을 확보하고 첫 번째 프레임 ID를 반환합니다.
+     * kNormal 존을 먼저 시도하고 모자라면 kDMA32 존을 사용한다.
+     */
+    WithError<FrameID> Allocate(size_t num_frames);
+    /** @brief 지정한 존 안에서 alignment 프레임 경계에 맞춘 공간을 확보합니다.
+     * 2의 거듭제곱으로 올림한 블록을 잘라 쓰고, 남는 꼬리는 즉시 빈 리스트로 돌려준다.
+     */
+    WithError<FrameID> Allocate(size_t num_frames, MemoryZone zone, size_t alignment);
+    /** @brief start_frame부터 num_frames 개의 프레임을 확보합니다. 하나라도 사용 중이면 실패합니다. */
+    Error AllocateAt(FrameID start_frame, size_t num_frames);
+    Error Free(FrameID start_frame, size_t num_frames);
+    void MarkAllocated(FrameID start_frame, size_t num_frames);
+    size_t CountFreeFrames(MemoryZone zone) const;
+    void SetMemoryRange(FrameID range_begin, FrameID range_end);
+
+    Stats GetStats() const;
+
+private:
+    /** @brief 빈 블록의 첫 프레임에 기록하는 헤더 */
+    struct FreeBlock {
+        FreeBlock* next;
+        FreeBlock* prev;
+        unsigned int order;
+    };
+
+    struct Extent {
+        size_t begin;
+        size_t end;
+        /** @brief 빈 블록의 첫 프레임이면 1이 되는 비트맵 */
+        MapLineType* head_map;
+    };
+
+    std::array<Extent, kMaxFrameExtents> extents_;
+    size_t num_extents_;
+    std::array<std::array<FreeBlock*, kMaxOrder + 1>, kMemoryZoneCount> free_lists_;
+    std::array<size_t, kMaxOrder + 1> free_counts_;
+    std::array<size_t, kMemoryZoneCount> zone_free_frames_;
+    FrameID range_begin_;
+    FrameID range_end_;
 
-    bool GetBit(FrameID frame) const;
-    void SetBit(FrameID frame, bool allocated);
+    /** @brief frame을 포함하는 익스텐트. 구멍이면 nullptr */
+    const Extent* ExtentOf(size_t frame) const;
+    bool IsFreeHead(size_t frame) const;
+    void SetFreeHead(size_t frame, bool head);
+    /** @brief [begin, end) 에서 처음 나오는 빈 블록의 첫 프레임. 없으면 end */
+    size_t FindFreeHead(size_t begin, size_t end) const;
+    /** @brief frame이 속한 빈 블록의 첫 프레임과 차수를 찾습니다. 없으면 false */
+    bool FindFreeBlock(size_t frame, size_t& head, unsigned int& order) const;
+    void PushFreeBlock(size_t frame, unsigned int order);
+    void RemoveFreeBlock(size_t frame, unsigned int order);
+    /** @brief 블록 하나를 해제하고 버디와 가능한 만큼 병합합니다. */
+    void ReleaseBlock(size_t frame, unsigned int order);
+    /** @brief [begin, end) 를 정렬된 블록들로 나누어 해제합니다. */
+    void ReleaseRange(size_t begin, size_t end);
 };
 
-void InitializeMemoryManager(const MemoryMap& memory_map);
\ No newline at end of file
+#ifdef USE_BUDDY_ALLOCATOR
+using MemoryManager = BuddyMemoryManager;
+#else
+using MemoryManager = BitmapMemoryManager;
+#endif
+
+extern MemoryManager* memory_manager;
+
+void InitializeMemoryManager(const MemoryMap& memory_map);
+
+/** @brief 부트 서비스가 쓰던 영역을 memory_manager에 돌려줍니다.
+ * UEFI의 페이지 테이블이 이 영역에 있으므로 InitializePaging으로 CR3를 바꾼 뒤에 호출해야 합니다.
+ */
+void ReleaseBootServicesMemory(const MemoryMap& memory_map);
+
+extern "C" {
+    /** @brief sbrk에서 호출한다. 힙 끝에 bytes 바이트 이상의 여유가 생기도록 프레임을 더 가져온다.
+     * 바로 뒤의 프레임이 비어 있으면 제자리에서 늘리고, 아니면 새 청크로 program_break를 옮긴다.
+     *
+     * @return 성공하면 0
+     */
+    int GrowHeap(size_t bytes);
+    /** @brief sbrk에서 break를 줄인 뒤 호출한다. break 뒤의 통째로 빈 프레임을 프레임 할당자에 돌려준다. */
+    void ShrinkHeap(void);
+}
\ No newline at end of file
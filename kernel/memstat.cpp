@@ -0,0 +1,86 @@
+#include "memstat.hpp"
+
+#include <array>
+
+#include "layer.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "slab.hpp"
+#include "usb/memory.hpp"
+#include "vmm.hpp"
+
+namespace {
+    const std::array<const char*, kFrameOwnerCount> kFrameOwnerNames{
+        "metadata", "page table", "heap", "slab", "kmalloc", "virtual", "zero pool", "usb",
+    };
+    const std::array<const char*, kHeapCategoryCount> kHeapCategoryNames{
+        "general", "graphics", "usb",
+    };
+
+    // 인터럽트 핸들러에서도 갱신하므로 __atomic 내장 함수로 읽고 쓴다
+    std::array<long, kFrameOwnerCount> frames_by_owner;
+    std::array<long, kHeapCategoryCount> heap_bytes_by_category;
+    HeapCategory current_heap_category;
+}
+
+void AccountFrames(FrameOwner owner, long frames) {
+    __atomic_fetch_add(&frames_by_owner[static_cast<size_t>(owner)], frames, __ATOMIC_RELAXED);
+}
+
+void AccountHeap(HeapCategory category, long bytes) {
+    __atomic_fetch_add(&heap_bytes_by_category[static_cast<size_t>(category)], bytes, __ATOMIC_RELAXED);
+}
+
+HeapCategory CurrentHeapCategory() {
+    return current_heap_category;
+}
+
+HeapCategoryScope::HeapCategoryScope(HeapCategory category)
+        : previous_{current_heap_category} {
+    current_heap_category = category;
+}
+
+HeapCategoryScope::~HeapCategoryScope() {
+    current_heap_category = previous_;
+}
+
+void LogMemoryStats() {
+    Log(kInfo, "memstat: free frames DMA32 %lu, Normal %lu, High %lu\n",
+        memory_manager->CountFreeFrames(MemoryZone::kDMA32),
+        memory_manager->CountFreeFrames(MemoryZone::kNormal),
+        memory_manager->CountFreeFrames(MemoryZone::kHigh));
+
+    const auto stats = memory_manager->GetStats();
+#ifdef USE_BUDDY_ALLOCATOR
+    Log(kInfo, "memstat: buddy %lu free frames, largest free block order %d\n",
+        stats.free_frames, stats.largest_free_order);
+    for (unsigned int order = 0; order <= BuddyMemoryManager::kMaxOrder; ++order) {
+        if (stats.free_blocks[order] > 0) {
+            Log(kInfo, "memstat:   order %2u: %lu blocks\n", order, stats.free_blocks[order]);
+        }
+    }
+#else
+    Log(kInfo, "memstat: bitmap %lu free frames in %lu runs, largest run %lu frames\n",
+        stats.free_frames, stats.free_runs, stats.largest_free_run);
+#endif
+
+    for (size_t i = 0; i < kFrameOwnerCount; ++i) {
+        Log(kInfo, "memstat: frames %-10s %8ld (%ld KiB)\n", kFrameOwnerNames[i],
+            __atomic_load_n(&frames_by_owner[i], __ATOMIC_RELAXED),
+            __atomic_load_n(&frames_by_owner[i], __ATOMIC_RELAXED) * 4);
+    }
+    for (size_t i = 0; i < kHeapCategoryCount; ++i) {
+        Log(kInfo, "memstat: heap %-10s %8ld bytes\n", kHeapCategoryNames[i],
+            __atomic_load_n(&heap_bytes_by_category[i], __ATOMIC_RELAXED));
+    }
+
+    const auto usb_usage = usb::GetDMAPoolUsage();
+    Log(kInfo, "memstat: usb dma %lu/%lu bytes in pools, %lu bytes in large blocks\n",
+        usb_usage.pool_bytes_in_use, usb_usage.pool_bytes_reserved, usb_usage.large_bytes);
+
+    Log(kInfo, "memstat: virtual %lu pages mapped\n", CountMappedVirtualPages());
+    if (layer_manager) {
+        layer_manager->LogSurfaceStats();
+    }
+    LogSlabStats();
+}
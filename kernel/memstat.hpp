@@ -0,0 +1,59 @@
+/**
+ * @file memstat.hpp
+ *
+ * 서브시스템별 메모리 사용량 카운터.
+ * 프레임은 소유자 태그별로, 커널 힙은 호출 측 범주별로 센다.
+ * LogMemoryStats가 프레임 할당자, 힙, USB DMA 풀, 레이어 표면 통계를 함께 로그로 출력한다.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/** @brief 프레임을 가져간 서브시스템 */
+enum class FrameOwner {
+    kMetadata,   // 프레임 관리자 자신의 비트맵
+    kPageTable,
+    kHeap,       // sbrk 힙
+    kSlab,
+    kKmalloc,    // 4KiB보다 큰 kmalloc
+    kVirtual,    // 커널 가상 영역의 demand-zero 페이지
+    kZeroPool,
+    kUSB,
+};
+const size_t kFrameOwnerCount = 8;
+
+/** @brief 커널 힙(kmalloc)을 사용하는 호출 측 범주 */
+enum class HeapCategory : uint8_t {
+    kGeneral,
+    kGraphics,
+    kUSB,
+};
+const size_t kHeapCategoryCount = 3;
+
+/** @brief owner가 가진 프레임 수에 frames를 더합니다. 해제 시에는 음수를 넘깁니다. */
+void AccountFrames(FrameOwner owner, long frames);
+/** @brief category가 사용 중인 힙 바이트 수에 bytes를 더합니다. 해제 시에는 음수를 넘깁니다. */
+void AccountHeap(HeapCategory category, long bytes);
+
+/** @brief 지금 할당하는 힙 메모리가 집계될 범주 */
+HeapCategory CurrentHeapCategory();
+
+/** @brief 생성 시 힙 범주를 바꾸고 소멸 시 되돌리는 클래스.
+ * 서브시스템의 진입점에 두면 그 안에서 일어나는 할당이 해당 범주로 집계된다.
+ * 그 사이에 들어온 인터럽트 핸들러의 할당도 같은 범주로 집계된다.
+ */
+class HeapCategoryScope {
+public:
+    explicit HeapCategoryScope(HeapCategory category);
+    ~HeapCategoryScope();
+    HeapCategoryScope(const HeapCategoryScope&) = delete;
+    HeapCategoryScope& operator=(const HeapCategoryScope&) = delete;
+
+private:
+    HeapCategory previous_;
+};
+
+/** @brief 모든 메모리 통계의 스냅샷을 로그로 출력합니다. */
+void LogMemoryStats();
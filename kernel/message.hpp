@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstddef>
+
 struct Message {
     enum Type {
         kNull,
         kInterruptXHCI,
         kTimerTimeout,
+        kSerialInput,
+        kNumTypes,
     } type;
 
     union {
@@ -14,4 +18,29 @@ struct Message {
         } timer;
         // ...
     } arg;
-};
\ No newline at end of file
+};
+
+/** @brief 메인 루프가 메시지를 처리하는 우선순위. 값이 작을수록 먼저 처리한다. */
+enum class MessagePriority {
+    kInput,
+    kXHCI,
+    kTimer,
+    kHousekeeping,
+};
+
+/** @brief 우선순위 단계의 수 */
+const size_t kNumMessagePriorities = 4;
+
+/** @brief 메시지 종류별 우선순위 */
+inline MessagePriority PriorityOf(Message::Type type) {
+    switch (type) {
+        case Message::kSerialInput:
+            return MessagePriority::kInput;
+        case Message::kInterruptXHCI:
+            return MessagePriority::kXHCI;
+        case Message::kTimerTimeout:
+            return MessagePriority::kTimer;
+        default:
+            return MessagePriority::kHousekeeping;
+    }
+}
@@ -0,0 +1,45 @@
+#include "message_queue.hpp"
+
+bool MessageQueue::Push(const Message& msg) {
+    if (!rings_[static_cast<size_t>(PriorityOf(msg.type))].Push(msg)) {
+        __atomic_fetch_add(&dropped_[msg.type], 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+bool MessageQueue::Pop(Message& msg) {
+    for (auto& ring : rings_) {
+        if (ring.Pop(msg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MessageQueue::Empty() const {
+    for (const auto& ring : rings_) {
+        if (!ring.Empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MessageQueue::Wait() const {
+    __asm__ volatile("cli" : : : "memory");
+    if (Empty()) {
+        // sti 직후 한 명령어 동안은 인터럽트가 지연되므로 hlt 전에 깨움을 놓치지 않는다
+        __asm__ volatile("sti\n\thlt" : : : "memory");
+    } else {
+        __asm__ volatile("sti" : : : "memory");
+    }
+}
+
+uint64_t MessageQueue::TotalDropped() const {
+    uint64_t total = 0;
+    for (const auto& ring : rings_) {
+        total += ring.Dropped();
+    }
+    return total;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "message.hpp"
+#include "mpsc_ring.hpp"
+
+/** @brief 인터럽트 핸들러가 메인 루프로 Message를 전달하는 메시지 큐.
+ *
+ * 우선순위마다 MpscRing을 하나씩 두어 Push는 메시지 종류의 우선순위(PriorityOf)에 해당하는 링에 넣고,
+ * Pop은 우선순위가 높은 링부터 꺼냅니다. 같은 우선순위 안에서는 FIFO입니다.
+ * 모든 멤버가 0인 상태가 곧 빈 큐이므로 전역 변수로 두어도 생성자 호출이 필요 없습니다.
+ */
+class MessageQueue {
+public:
+    /** @brief 우선순위 하나의 링이 담을 수 있는 메시지 수. 2의 거듭제곱이어야 한다. */
+    static const size_t kRingCapacity = 256;
+
+    /** @brief 메시지를 우선순위에 맞는 링에 넣습니다. 인터럽트 핸들러에서 호출할 수 있습니다.
+     * @return 링이 가득 차 버려진 경우 false
+     */
+    bool Push(const Message& msg);
+
+    /** @brief 우선순위가 가장 높은 메시지를 꺼냅니다. 메인 루프에서만 호출해야 합니다.
+     * @return 꺼낸 메시지가 있으면 true
+     */
+    bool Pop(Message& msg);
+
+    /** @brief 모든 링이 비어 있는지 여부 */
+    bool Empty() const;
+
+    /** @brief 큐가 비어 있으면 다음 인터럽트까지 hlt로 잠듭니다.
+     * 검사와 sti; hlt 사이에 인터럽트를 금지하므로 Push 직후의 깨움을 놓치지 않습니다.
+     */
+    void Wait() const;
+
+    /** @brief type 종류의 메시지가 링이 가득 차서 버려진 누적 개수 */
+    uint64_t Dropped(Message::Type type) const {
+        return __atomic_load_n(&dropped_[type], __ATOMIC_RELAXED);
+    }
+
+    /** @brief 모든 링에서 버려진 메시지의 누적 개수 */
+    uint64_t TotalDropped() const;
+
+private:
+    std::array<MpscRing<Message, kRingCapacity>, kNumMessagePriorities> rings_;
+    std::array<uint64_t, Message::kNumTypes> dropped_;
+};
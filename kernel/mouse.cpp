@@ -4,6 +4,8 @@
 #include "layer.hpp"
 #include "usb/classdriver/mouse.hpp"
 #include "logger.hpp"
+#include "memstat.hpp"
+#include "trace.hpp"
 
 namespace {
     const char mouse_cursor_shape[kMouseCursorHeight][kMouseCursorWidth + 1] = {
@@ -68,6 +70,7 @@ void Mouse::OnInterrupt(uint8_t buttons, int8_t displacement_x, int8_t displacem
     const auto posdiff = position_ - oldpos;
 
     layer_manager->Move(layer_id_, position_);
+    TRACE(MouseMove, position_.x, position_.y, buttons);
 
     const bool previous_left_pressed = (previous_buttons_ & 0x01);
     const bool left_pressed = (buttons & 0x01);
@@ -75,26 +78,28 @@ void Mouse::OnInterrupt(uint8_t buttons, int8_t displacement_x, int8_t displacem
         auto layer = layer_manager->FindLayerByPosition(position_, layer_id_);
         if (layer && layer->IsDraggable()) {
             drag_layer_id_ = layer->ID();
-            Log(kInfo, "Mouse Clicked on layer %d\n", drag_layer_id_);
+            TRACE(MouseDragStart, drag_layer_id_);
         }
     } else if (previous_left_pressed && left_pressed) {
         if (drag_layer_id_ > 0) {
             layer_manager->MoveRelative(drag_layer_id_, posdiff);
-            Log(kInfo, "Mouse drag moved layer %d\n", drag_layer_id_);
+            TRACE(MouseDragMove, drag_layer_id_, posdiff.x, posdiff.y);
         }
     } else if (previous_left_pressed && !left_pressed) {
+        TRACE(MouseDragEnd, drag_layer_id_);
         drag_layer_id_ = 0;
-        Log(kInfo, "Mouse drag ended\n");
     }
 
     previous_buttons_ = buttons;
 }
 
 void InitializeMouse() {
-    auto mouse_window = std::make_shared<Window>(
+    HeapCategoryScope heap_category{HeapCategory::kGraphics};
+    auto mouse_window = MakeSlabShared<Window>(
             kMouseCursorWidth, kMouseCursorHeight, screen_config.pixel_format);
     mouse_window->SetTransparentColor(kMouseTransparentColor);
     DrawMouseCursor(mouse_window->Writer(), {0, 0});
+    mouse_window->SetRedrawCallback([](Window& window) { DrawMouseCursor(window.Writer(), {0, 0}); });
 
     auto mouse_layer_id = layer_manager->NewLayer()
             .SetWindow(mouse_window)
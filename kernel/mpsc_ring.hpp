@@ -0,0 +1,112 @@
+/**
+ * @file mpsc_ring.hpp
+ *
+ * 인터럽트 핸들러에서도 쓸 수 있는 여러 생산자, 단일 소비자용 고정 길이 lock-free 링.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/** @brief 여러 생산자, 단일 소비자용 고정 길이 lock-free 링.
+ *
+ * 생산자는 head_를 CAS로 전진시켜 슬롯을 선점한 뒤 요소를 채우고 turn으로 공개합니다.
+ * 락을 잡지 않고 메모리를 할당하지 않으므로 인터럽트 핸들러 안에서도 호출할 수 있으며,
+ * 링이 가득 찬 경우 기다리지 않고 요소를 버린 뒤 Dropped 카운터를 증가시킵니다.
+ *
+ * 슬롯 i의 turn은 lap = pos / N에 대해
+ * 2 * lap이면 쓰기 가능, 2 * lap + 1이면 읽기 가능 상태를 나타냅니다.
+ * 따라서 모든 멤버가 0으로 초기화된 상태가 곧 빈 링이며, 전역 생성자 호출이 필요 없습니다.
+ * libc++가 스레드 미지원으로 빌드되어 <atomic>을 쓸 수 없으므로 __atomic 내장 함수를 사용합니다.
+ *
+ * @tparam T 요소 타입. 슬롯 사이에 대입으로 복사된다.
+ * @tparam N 슬롯 수. 2의 거듭제곱이어야 한다.
+ */
+template <typename T, size_t N>
+class MpscRing {
+public:
+    static_assert((N & (N - 1)) == 0, "MpscRing capacity must be a power of two");
+
+    static const size_t kCapacity = N;
+
+    /** @brief 슬롯 하나를 선점하고 fill(요소, 일련번호)로 슬롯 안에서 직접 채운 뒤 공개합니다.
+     * 일련번호는 링에 들어간 순서대로 0부터 증가합니다. 큰 요소를 복사하지 않고 만들 때 사용합니다.
+     * @return 링이 가득 차 버려진 경우 false
+     */
+    template <typename Fill>
+    bool PushWith(Fill fill);
+
+    /** @brief 요소를 넣습니다. 인터럽트 핸들러에서 호출할 수 있습니다.
+     * @return 링이 가득 차 버려진 경우 false
+     */
+    bool Push(const T& value) {
+        return PushWith([&value](T& slot, uint64_t) { slot = value; });
+    }
+
+    /** @brief 가장 오래된 요소를 꺼냅니다. 단일 소비자에서만 호출해야 합니다.
+     * @return 꺼낸 요소가 있으면 true
+     */
+    bool Pop(T& value);
+
+    /** @brief 꺼낼 요소가 없는지 여부. 소비자에서만 의미가 있습니다. */
+    bool Empty() const {
+        return __atomic_load_n(&slots_[tail_ % N].turn, __ATOMIC_ACQUIRE) != 2 * (tail_ / N) + 1;
+    }
+
+    /** @brief 링이 가득 차서 버려진 요소의 누적 개수 */
+    uint64_t Dropped() const { return __atomic_load_n(&dropped_, __ATOMIC_RELAXED); }
+
+private:
+    struct Slot {
+        uint64_t turn;
+        T value;
+    };
+
+    std::array<Slot, N> slots_;
+    uint64_t head_;
+    uint64_t tail_;
+    uint64_t dropped_;
+};
+
+template <typename T, size_t N>
+template <typename Fill>
+bool MpscRing<T, N>::PushWith(Fill fill) {
+    uint64_t pos = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[pos % N];
+        const uint64_t turn = __atomic_load_n(&slot->turn, __ATOMIC_ACQUIRE);
+        const uint64_t expected = 2 * (pos / N);
+        if (turn == expected) {
+            if (__atomic_compare_exchange_n(&head_, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (turn < expected) {
+            // 이전 바퀴의 요소가 아직 소비되지 않음: 링이 가득 참
+            __atomic_fetch_add(&dropped_, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+        }
+    }
+
+    fill(slot->value, pos);
+    __atomic_store_n(&slot->turn, 2 * (pos / N) + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+template <typename T, size_t N>
+bool MpscRing<T, N>::Pop(T& value) {
+    auto& slot = slots_[tail_ % N];
+    if (__atomic_load_n(&slot.turn, __ATOMIC_ACQUIRE) != 2 * (tail_ / N) + 1) {
+        return false;
+    }
+
+    value = slot.value;
+    __atomic_store_n(&slot.turn, 2 * (tail_ / N) + 2, __ATOMIC_RELEASE);
+    ++tail_;
+    return true;
+}
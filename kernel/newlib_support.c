@@ -1,5 +1,10 @@
 #include <errno.h>
+#include <stdint.h>
+#include <reent.h>
+#include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 
 void _exit(void) {
     while (1) __asm__("hlt");
@@ -7,8 +12,18 @@ void _exit(void) {
 
 caddr_t program_break, program_break_end;
 
+int GrowHeap(size_t bytes);
+void ShrinkHeap(void);
+
 caddr_t sbrk(int incr) {
-    if (program_break == 0 || program_break + incr >= program_break_end) {
+    if (incr < 0) {
+        caddr_t prev_break = program_break;
+        program_break += incr;
+        ShrinkHeap();
+        return prev_break;
+    }
+
+    if (program_break + incr > program_break_end && GrowHeap(incr) != 0) {
         errno = ENOMEM;
         return (caddr_t)-1;
     }
@@ -18,6 +33,148 @@ caddr_t sbrk(int incr) {
     return prev_break;
 }
 
+void* KernelMalloc(size_t size, size_t alignment);
+void KernelFree(void* p);
+size_t KernelMallocUsableSize(void* p);
+
+/* newlib의 malloc 대신 커널 malloc(kmalloc.cpp)을 사용한다.
+ * newlib 내부에서 부르는 _r 버전도 정의해 두어야 mallocr.o가 링크되지 않는다. */
+
+void* malloc(size_t size) {
+    void* p = KernelMalloc(size, 0);
+    if (p == NULL) {
+        errno = ENOMEM;
+    }
+    return p;
+}
+
+void free(void* p) {
+    KernelFree(p);
+}
+
+void* calloc(size_t n, size_t size) {
+    if (size != 0 && n > (size_t)-1 / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void* p = malloc(n * size);
+    if (p != NULL) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void* realloc(void* p, size_t size) {
+    if (p == NULL) {
+        return malloc(size);
+    }
+    if (size == 0) {
+        free(p);
+        return NULL;
+    }
+
+    size_t usable = KernelMallocUsableSize(p);
+    if (size <= usable) {
+        return p;
+    }
+    void* new_p = malloc(size);
+    if (new_p != NULL) {
+        memcpy(new_p, p, usable);
+        free(p);
+    }
+    return new_p;
+}
+
+void* memalign(size_t alignment, size_t size) {
+    void* p = KernelMalloc(size, alignment);
+    if (p == NULL) {
+        errno = ENOMEM;
+    }
+    return p;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* p = KernelMalloc(size, alignment);
+    if (p == NULL) {
+        return ENOMEM;
+    }
+    *memptr = p;
+    return 0;
+}
+
+size_t malloc_usable_size(void* p) {
+    return KernelMallocUsableSize(p);
+}
+
+void* _malloc_r(struct _reent* r, size_t size) {
+    return malloc(size);
+}
+
+void _free_r(struct _reent* r, void* p) {
+    free(p);
+}
+
+void* _calloc_r(struct _reent* r, size_t n, size_t size) {
+    return calloc(n, size);
+}
+
+void* _realloc_r(struct _reent* r, void* p, size_t size) {
+    return realloc(p, size);
+}
+
+void* _memalign_r(struct _reent* r, size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+size_t _malloc_usable_size_r(struct _reent* r, void* p) {
+    return malloc_usable_size(p);
+}
+
+uint64_t NowNs(void);
+uint64_t RealtimeNs(void);
+
+/* 커널 빌드 설정에 따라 time.h가 시계 ID를 정의하지 않을 수 있다 */
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME ((clockid_t)1)
+#endif
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC ((clockid_t)4)
+#endif
+
+int clock_gettime(clockid_t clock_id, struct timespec* tp) {
+    uint64_t ns;
+    if (clock_id == CLOCK_MONOTONIC) {
+        ns = NowNs();
+    } else if (clock_id == CLOCK_REALTIME) {
+        ns = RealtimeNs();
+    } else {
+        errno = EINVAL;
+        return -1;
+    }
+    tp->tv_sec = ns / 1000000000;
+    tp->tv_nsec = ns % 1000000000;
+    return 0;
+}
+
+int gettimeofday(struct timeval* tv, void* tz) {
+    const uint64_t ns = RealtimeNs();
+    tv->tv_sec = ns / 1000000000;
+    tv->tv_usec = ns % 1000000000 / 1000;
+    return 0;
+}
+
+/* time() 등 newlib 내부는 _gettimeofday_r을 거쳐 이 함수를 부른다 */
+int _gettimeofday(struct timeval* tv, void* tz) {
+    return gettimeofday(tv, tz);
+}
+
 int getpid(void) {
     return 1;
 }
@@ -1,32 +1,155 @@
 #include "paging.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cpuid.h>
+#include <cstdlib>
 
 #include "asmfunc.h"
+#include "graphics.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "zero_pool.hpp"
 
 namespace {
     const uint64_t kPageSize4K = 4096;
     const uint64_t kPageSize2M = 512 * kPageSize4K;
     const uint64_t kPageSize1G = 512 * kPageSize2M;
 
+    const uint64_t kPresent = 0x001;
+    const uint64_t kPresentWritable = 0x003;
+    /** @brief CR0의 쓰기 보호 비트. 켜면 커널 모드의 쓰기도 읽기 전용 페이지에서 폴트가 된다. */
+    const uint64_t kCR0WriteProtect = 1u << 16;
+    const uint64_t kLargePage = 0x080;
+    const uint64_t kAddressMask = 0x000ffffffffff000;
+
+    /** @brief CPUID 0x80000001 EDX의 1GiB 페이지 지원 비트 */
+    const uint32_t kCPUIDPdpe1GB = 1u << 26;
+
     alignas(kPageSize4K) std::array<uint64_t, 512> pml4_table;
-    alignas(kPageSize4K) std::array<uint64_t, 512> pdp_table;
-    alignas(kPageSize4K)
-        std::array<std::array<uint64_t, 512>, kPageDirectoryCount> page_directory;
+    bool use_1gib_pages;
+
+    bool Supports1GiBPages() {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return edx & kCPUIDPdpe1GB;
+    }
+
+    /** @brief entry가 가리키는 하위 테이블을 반환합니다. 없으면 0으로 채운 프레임을 할당해 연결합니다. */
+    WithError<uint64_t*> GetOrNewTable(uint64_t& entry) {
+        if (entry & kPresent) {
+            return {reinterpret_cast<uint64_t*>(entry & kAddressMask), MAKE_ERROR(Error::kSuccess)};
+        }
+
+        const auto frame = AllocateFrames(1, FrameOwner::kPageTable, true);
+        if (frame.error) {
+            return {nullptr, frame.error};
+        }
+        auto table = reinterpret_cast<uint64_t*>(frame.value.Frame());
+        entry = reinterpret_cast<uint64_t>(table) | kPresentWritable;
+        return {table, MAKE_ERROR(Error::kSuccess)};
+    }
+
+    /** @brief level 단계(1 = 페이지 테이블, 4 = PML4) 테이블에서 addr이 쓰는 엔트리 번호 */
+    int PageTableIndex(uint64_t addr, int level) {
+        return (addr >> (12 + 9 * (level - 1))) & 0x1ff;
+    }
 }
 
-void SetupIdentityPageTable() {
-    pml4_table[0] = reinterpret_cast<uint64_t>(&pdp_table[0]) | 0x003;
-    for (int i_pdpt = 0; i_pdpt < page_directory.size(); ++i_pdpt) {
-        pdp_table[i_pdpt] = reinterpret_cast<uint64_t>(&page_directory[i_pdpt]) | 0x003;
-        for (int i_pd = 0; i_pd < 512; ++i_pd) {
-            page_directory[i_pdpt][i_pd] = i_pdpt * kPageSize1G + i_pd * kPageSize2M | 0x083;
+Error MapIdentity(uint64_t addr, uint64_t size) {
+    const uint64_t page_size = use_1gib_pages ? kPageSize1G : kPageSize2M;
+    const uint64_t begin = addr & ~(page_size - 1);
+    const uint64_t end = std::min((addr + size + page_size - 1) & ~(page_size - 1), kIdentityMapLimit);
+
+    for (uint64_t page = begin; page < end; page += page_size) {
+        const auto pdp_table = GetOrNewTable(pml4_table[PageTableIndex(page, 4)]);
+        if (pdp_table.error) {
+            return pdp_table.error;
+        }
+        auto& pdp_entry = pdp_table.value[PageTableIndex(page, 3)];
+        if (use_1gib_pages) {
+            pdp_entry = page | kLargePage | kPresentWritable;
+            continue;
         }
+
+        const auto page_directory = GetOrNewTable(pdp_entry);
+        if (page_directory.error) {
+            return page_directory.error;
+        }
+        page_directory.value[PageTableIndex(page, 2)] = page | kLargePage | kPresentWritable;
     }
+    return MAKE_ERROR(Error::kSuccess);
+}
+
+void SetupIdentityPageTable(const MemoryMap& memory_map) {
+    use_1gib_pages = Supports1GiBPages();
 
+    // Local APIC, I/O APIC, 32비트 PCI BAR가 놓이는 4GiB 아래는 구멍까지 모두 매핑한다
+    Error err = MapIdentity(0, uint64_t{4} << 30);
+
+    const auto memory_map_base = reinterpret_cast<uintptr_t>(memory_map.buffer);
+    for (uintptr_t iter = memory_map_base;
+         !err && iter < memory_map_base + memory_map.map_size;
+         iter += memory_map.descriptor_size) {
+        auto desc = reinterpret_cast<const MemoryDescriptor*>(iter);
+        err = MapIdentity(desc->physical_start, desc->number_of_pages * kUEFIPageSize);
+    }
+    if (!err) {
+        const uint64_t frame_buffer_size = uint64_t{4} *
+            screen_config.pixels_per_scan_line * screen_config.vertical_resolution;
+        err = MapIdentity(reinterpret_cast<uint64_t>(screen_config.frame_buffer), frame_buffer_size);
+    }
+    if (err) {
+        Log(kError, "failed to build identity page table: %s at %s:%d\n",
+            err.Name(), err.File(), err.Line());
+        exit(1);
+    }
+
+    Log(kInfo, "Identity page table: %s pages\n", use_1gib_pages ? "1GiB" : "2MiB");
     SetCR3(reinterpret_cast<uint64_t>(&pml4_table[0]));
+    SetCR0(GetCR0() | kCR0WriteProtect);
 }
 
-void InitializePaging() {
-    SetupIdentityPageTable();
-}
\ No newline at end of file
+Error MapPage(uint64_t virt_addr, uint64_t phys_addr, bool writable) {
+    uint64_t* table = pml4_table.data();
+    for (int level = 4; level > 1; --level) {
+        const auto next = GetOrNewTable(table[PageTableIndex(virt_addr, level)]);
+        if (next.error) {
+            return next.error;
+        }
+        table = next.value;
+    }
+    auto& entry = table[PageTableIndex(virt_addr, 1)];
+    const bool was_present = entry & kPresent;
+    entry = (phys_addr & kAddressMask) | (writable ? kPresentWritable : kPresent);
+    if (was_present) {
+        InvalidateTLB(virt_addr);
+    }
+    return MAKE_ERROR(Error::kSuccess);
+}
+
+uint64_t UnmapPage(uint64_t virt_addr) {
+    uint64_t* table = pml4_table.data();
+    for (int level = 4; level > 1; --level) {
+        const uint64_t entry = table[PageTableIndex(virt_addr, level)];
+        if ((entry & kPresent) == 0 || (entry & kLargePage)) {
+            return 0;
+        }
+        table = reinterpret_cast<uint64_t*>(entry & kAddressMask);
+    }
+
+    auto& entry = table[PageTableIndex(virt_addr, 1)];
+    if ((entry & kPresent) == 0) {
+        return 0;
+    }
+    const uint64_t phys_addr = entry & kAddressMask;
+    entry = 0;
+    InvalidateTLB(virt_addr);
+    return phys_addr;
+}
+
+void InitializePaging(const MemoryMap& memory_map) {
+    SetupIdentityPageTable(memory_map);
+}
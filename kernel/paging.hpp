@@ -1,17 +1,40 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
-/** @brief 정적으로 예약할 페이지 디렉토리 수
- * 이 상수는 SetupIdentityPageMap에서 사용됩니다.
- * 한 페이지 디렉토리에 512 개의 2MiB 페이지를 설정할 수 있으므로,
- * kPageDirectoryCount x 1GiB의 가상 주소가 매핑됩니다.
+#include "error.hpp"
+#include "memory_map.hpp"
+
+/** @brief 아이덴티티 매핑할 수 있는 물리 주소의 상한(512GiB)
+ * PML4 엔트리 하나가 가리키는 PDPT 한 장이 덮는 범위입니다.
+ * 이보다 위의 물리 메모리는 kHigh 존으로 남습니다.
  */
-const size_t kPageDirectoryCount = 64;
+const uint64_t kIdentityMapLimit = uint64_t{512} << 30;
 
 /** @brief 가상 주소 = 물리적 주소가 되도록 페이지 테이블을 설정합니다.
+ * 메모리 맵에 나타난 영역과 4GiB 아래의 MMIO 영역, 프레임 버퍼만 매핑하며,
+ * CPU가 지원하면 1GiB 페이지를, 그렇지 않으면 2MiB 페이지를 사용합니다.
+ * 페이지 테이블은 memory_manager에서 할당하므로 InitializeMemoryManager 이후에 호출해야 합니다.
  * 궁극적으로 CR3 레지스터가 올바르게 설정된 페이지 테이블을 가리킵니다.
  */
-void SetupIdentityPageTable();
+void SetupIdentityPageTable(const MemoryMap& memory_map);
+
+/** @brief [addr, addr + size)를 아이덴티티 매핑합니다.
+ * 페이지 크기 단위로 넓혀 매핑하며, 4GiB 위에 배치된 MMIO 영역을 매핑할 때 사용합니다.
+ */
+Error MapIdentity(uint64_t addr, uint64_t size);
+
+/** @brief 가상 주소 virt_addr의 4KiB 페이지를 물리 주소 phys_addr에 매핑합니다.
+ * 필요한 하위 페이지 테이블은 memory_manager에서 할당합니다.
+ * 이미 매핑된 페이지면 새 매핑으로 바꾸고 TLB를 무효화합니다.
+ * @param writable false면 읽기 전용으로 매핑한다. CR0.WP가 켜져 있어 커널의 쓰기도 폴트가 된다.
+ */
+Error MapPage(uint64_t virt_addr, uint64_t phys_addr, bool writable = true);
+
+/** @brief 가상 주소 virt_addr의 4KiB 매핑을 제거하고 TLB를 무효화합니다.
+ * @return 매핑되어 있던 물리 주소. 매핑이 없었으면 0
+ */
+uint64_t UnmapPage(uint64_t virt_addr);
 
-void InitializePaging();
\ No newline at end of file
+void InitializePaging(const MemoryMap& memory_map);
@@ -0,0 +1,81 @@
+#include "reclaim.hpp"
+
+#include <array>
+
+#include "interrupt.hpp"
+#include "kmalloc.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "slab.hpp"
+#include "timer.hpp"
+#include "zero_pool.hpp"
+
+namespace {
+    const size_t kMaxReclaimHooks = 8;
+
+    struct RegisteredHook {
+        const char* name;
+        ReclaimHook hook;
+    };
+
+    std::array<RegisteredHook, kMaxReclaimHooks> hooks;
+    size_t num_hooks;
+
+    unsigned long last_check_tick;
+    bool under_pressure;
+
+    size_t CountAllFreeFrames() {
+        InterruptGuard guard;
+        return memory_manager->CountFreeFrames(MemoryZone::kDMA32) +
+            memory_manager->CountFreeFrames(MemoryZone::kNormal);
+    }
+
+    /** @brief 할당자 자신의 캐시를 비웁니다. */
+    size_t ReclaimAllocatorCaches(size_t frames_wanted) {
+        size_t frames = DrainZeroPool(frames_wanted);
+        if (frames >= frames_wanted) {
+            return frames;
+        }
+
+        FlushKernelMallocCaches();
+        InterruptGuard guard;
+        return frames + ShrinkSlabCaches();
+    }
+}
+
+bool RegisterReclaimHook(const char* name, ReclaimHook hook) {
+    if (num_hooks == kMaxReclaimHooks) {
+        return false;
+    }
+    hooks[num_hooks++] = {name, hook};
+    return true;
+}
+
+size_t ReclaimMemory(size_t frames_wanted) {
+    size_t frames = ReclaimAllocatorCaches(frames_wanted);
+    Log(kDebug, "reclaim: allocator caches %lu frames\n", frames);
+    for (size_t i = 0; i < num_hooks && frames < frames_wanted; ++i) {
+        const size_t reclaimed = hooks[i].hook(frames_wanted - frames);
+        Log(kDebug, "reclaim: %s %lu frames\n", hooks[i].name, reclaimed);
+        frames += reclaimed;
+    }
+    return frames;
+}
+
+void CheckMemoryPressure(unsigned long tick) {
+    if (tick - last_check_tick < MillisecondsToTicks(kPressureCheckIntervalMilliseconds)) {
+        return;
+    }
+    last_check_tick = tick;
+
+    const size_t free_frames = CountAllFreeFrames();
+    under_pressure = free_frames < kLowWatermarkFrames;
+    if (under_pressure) {
+        const size_t reclaimed = ReclaimMemory(kHighWatermarkFrames - free_frames);
+        Log(kWarn, "memory pressure: %lu free frames, reclaimed %lu\n", free_frames, reclaimed);
+    }
+}
+
+bool UnderMemoryPressure() {
+    return under_pressure;
+}
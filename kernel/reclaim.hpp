@@ -0,0 +1,40 @@
+/**
+ * @file reclaim.hpp
+ *
+ * 메모리 부족 시 캐시와 다시 만들 수 있는 자료를 해제하는 회수 기능.
+ * 할당자 자신의 캐시(0 프레임 풀, kmalloc CPU별 캐시, 빈 슬랩)를 먼저 비우고,
+ * 모자라면 서브시스템이 등록한 회수 함수를 등록 순서대로 호출한다.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/** @brief 빈 프레임이 이보다 적으면 메모리 부족으로 보고 회수를 시작한다(16MiB) */
+const size_t kLowWatermarkFrames = 4096;
+/** @brief 회수는 빈 프레임이 이만큼이 될 때까지 한다(32MiB) */
+const size_t kHighWatermarkFrames = 8192;
+/** @brief 빈 프레임 수를 세는 간격(밀리초). 비트맵 할당자에서는 세는 데 전체 스캔이 필요하다 */
+const unsigned long kPressureCheckIntervalMilliseconds = 100;
+
+/** @brief 회수 함수. 최대 frames_wanted 프레임 정도를 해제하고 해제한 프레임 수(추정치)를 반환한다. */
+using ReclaimHook = size_t (*)(size_t frames_wanted);
+
+/** @brief 회수 함수를 등록합니다. 등록할 자리가 없으면 false */
+bool RegisterReclaimHook(const char* name, ReclaimHook hook);
+
+/** @brief frames_wanted 프레임을 목표로 메모리를 회수합니다.
+ * 회수 함수는 표면 버퍼 등 메인 루프가 쓰는 자료를 해제하므로 메인 루프에서만 호출해야 합니다.
+ *
+ * @return 회수한 프레임 수(추정치)
+ */
+size_t ReclaimMemory(size_t frames_wanted);
+
+/** @brief 메인 루프의 유휴 시간에 호출합니다.
+ * 마지막 확인에서 kPressureCheckIntervalMilliseconds 이상 지났으면 빈 프레임 수를 세어,
+ * kLowWatermarkFrames보다 적으면 kHighWatermarkFrames까지 회수합니다.
+ */
+void CheckMemoryPressure(unsigned long tick);
+
+/** @brief 마지막 확인에서 메모리 부족 상태였는지 여부. 0 프레임 풀은 이 동안 채우지 않는다 */
+bool UnderMemoryPressure();
@@ -0,0 +1,213 @@
+#include "serial.hpp"
+
+#include "asmfunc.h"
+#include "interrupt.hpp"
+#include "logger.hpp"
+#include "log_ring.hpp"
+
+namespace {
+    const uint16_t kCOM1 = 0x3f8;
+    const uint8_t kCOM1IRQ = 4;
+    const size_t kTxFifoSize = 16;
+
+    // 레지스터 오프셋
+    const uint16_t kData = 0;          // THR/RBR, DLAB=1이면 DLL
+    const uint16_t kIntEnable = 1;     // IER, DLAB=1이면 DLM
+    const uint16_t kIntIdent = 2;      // IIR(읽기) / FCR(쓰기)
+    const uint16_t kLineControl = 3;   // LCR
+    const uint16_t kModemControl = 4;  // MCR
+    const uint16_t kLineStatus = 5;    // LSR
+    const uint16_t kModemStatus = 6;   // MSR
+
+    const uint8_t kIERReceived = 0x01;
+    const uint8_t kIERTxEmpty = 0x02;
+    const uint8_t kLSRDataReady = 0x01;
+    const uint8_t kLSRTxEmpty = 0x20;
+
+    static_assert((SerialPort::kTxRingSize & (SerialPort::kTxRingSize - 1)) == 0);
+    static_assert((SerialPort::kRxRingSize & (SerialPort::kRxRingSize - 1)) == 0);
+}
+
+SerialPort::SerialPort(uint16_t io_base) : io_base_{io_base} {}
+
+bool SerialPort::Initialize() {
+    IoOut8(io_base_ + kIntEnable, 0);
+    IoOut8(io_base_ + kLineControl, 0x80);   // DLAB=1
+    IoOut8(io_base_ + kData, 1);             // 115200 / 1
+    IoOut8(io_base_ + kIntEnable, 0);
+    IoOut8(io_base_ + kLineControl, 0x03);   // 8N1, DLAB=0
+    IoOut8(io_base_ + kIntIdent, 0xc7);      // FIFO 활성화 및 초기화, 수신 임계치 14바이트
+
+    IoOut8(io_base_ + kModemControl, 0x1e);  // 루프백 모드로 동작 확인
+    IoOut8(io_base_ + kData, 0xae);
+    if (IoIn8(io_base_ + kData) != 0xae) {
+        return false;
+    }
+
+    IoOut8(io_base_ + kModemControl, 0x0b);  // DTR, RTS, OUT2(IRQ 출력 활성화)
+    ier_ = kIERReceived;
+    IoOut8(io_base_ + kIntEnable, ier_);
+    return true;
+}
+
+size_t SerialPort::TxPending() const {
+    return __atomic_load_n(&tx_head_, __ATOMIC_ACQUIRE) - tx_tail_;
+}
+
+size_t SerialPort::Write(const char* s, size_t len) {
+    size_t head = tx_head_;
+    size_t written = 0;
+    while (written < len) {
+        if (head - __atomic_load_n(&tx_tail_, __ATOMIC_ACQUIRE) == kTxRingSize) {
+            break;
+        }
+        tx_ring_[head % kTxRingSize] = s[written++];
+        ++head;
+    }
+    __atomic_store_n(&tx_head_, head, __ATOMIC_RELEASE);
+    if (written < len) {
+        tx_dropped_ += len - written;
+    }
+
+    InterruptGuard guard;
+    if (guard.WasEnabled()) {
+        // THRE 인터럽트를 켜면 FIFO가 비어 있는 경우 바로 인터럽트가 발생한다
+        EnableTxInterrupt(true);
+    } else {
+        DrainTx(true);
+    }
+    return written;
+}
+
+size_t SerialPort::Read(char* buf, size_t len) {
+    size_t read = 0;
+    size_t tail = rx_tail_;
+    while (read < len && tail != __atomic_load_n(&rx_head_, __ATOMIC_ACQUIRE)) {
+        buf[read++] = rx_ring_[tail % kRxRingSize];
+        ++tail;
+    }
+    __atomic_store_n(&rx_tail_, tail, __ATOMIC_RELEASE);
+    return read;
+}
+
+bool SerialPort::OnInterrupt() {
+    bool notify = false;
+    while (true) {
+        const uint8_t iir = IoIn8(io_base_ + kIntIdent);
+        if (iir & 0x01) {
+            break;  // 처리할 인터럽트 없음
+        }
+
+        switch ((iir >> 1) & 0x07) {
+            case 0:  // 모뎀 상태 변화
+                IoIn8(io_base_ + kModemStatus);
+                break;
+            case 1:  // 송신 FIFO 비었음
+                DrainTx(false);
+                if (TxPending() == 0 && notify_tx_empty_) {
+                    notify_tx_empty_ = false;
+                    notify = true;
+                }
+                break;
+            case 2:  // 수신 데이터
+            case 6:  // 수신 타임아웃
+                while (IoIn8(io_base_ + kLineStatus) & kLSRDataReady) {
+                    const char c = IoIn8(io_base_ + kData);
+                    const size_t head = rx_head_;
+                    if (head - __atomic_load_n(&rx_tail_, __ATOMIC_ACQUIRE) < kRxRingSize) {
+                        rx_ring_[head % kRxRingSize] = c;
+                        __atomic_store_n(&rx_head_, head + 1, __ATOMIC_RELEASE);
+                        notify = true;
+                    }
+                }
+                break;
+            case 3:  // 수신 라인 상태
+                IoIn8(io_base_ + kLineStatus);
+                break;
+        }
+    }
+    return notify;
+}
+
+void SerialPort::EnableTxInterrupt(bool enable) {
+    const uint8_t ier = enable ? (ier_ | kIERTxEmpty) : (ier_ & ~kIERTxEmpty);
+    if (ier != ier_) {
+        ier_ = ier;
+        IoOut8(io_base_ + kIntEnable, ier_);
+    }
+}
+
+/** @brief TX 링의 내용을 송신 FIFO로 옮긴다. 인터럽트가 금지된 상태에서만 호출한다.
+ * @param wait_fifo true이면 링이 빌 때까지 FIFO가 비기를 폴링하며 모두 보낸다.
+ *                  false이면 FIFO가 비었다는 전제로 최대 FIFO 크기만큼만 보낸다.
+ */
+void SerialPort::DrainTx(bool wait_fifo) {
+    do {
+        if (wait_fifo) {
+            while ((IoIn8(io_base_ + kLineStatus) & kLSRTxEmpty) == 0);
+        }
+        for (size_t i = 0; i < kTxFifoSize && TxPending() > 0; ++i) {
+            IoOut8(io_base_ + kData, tx_ring_[tx_tail_ % kTxRingSize]);
+            __atomic_store_n(&tx_tail_, tx_tail_ + 1, __ATOMIC_RELEASE);
+        }
+    } while (wait_fifo && TxPending() > 0);
+
+    EnableTxInterrupt(TxPending() > 0);
+}
+
+SerialPort* serial_port;
+
+namespace {
+    char serial_port_buf[sizeof(SerialPort)];
+
+    /** @brief 로그 레코드를 시리얼 포트로 보내는 로그 싱크. 개행은 CRLF로 바꾼다. */
+    class SerialLogSink : public LogSink {
+    public:
+        void Write(const LogRecord& record) override {
+            if (paused) {
+                return;
+            }
+            const char* s = record.text;
+            while (*s) {
+                const char* line = s;
+                while (*s && *s != '\n') {
+                    ++s;
+                }
+                serial_port->Write(line, s - line);
+                if (*s == '\n') {
+                    serial_port->Write("\r\n", 2);
+                    ++s;
+                }
+            }
+        }
+
+        bool paused = false;
+    };
+
+    char serial_log_sink_buf[sizeof(SerialLogSink)];
+    SerialLogSink* serial_log_sink;
+}
+
+bool SerialOnInterrupt() {
+    return serial_port && serial_port->OnInterrupt();
+}
+
+void InitializeSerial() {
+    auto port = new(serial_port_buf) SerialPort{kCOM1};
+    if (!port->Initialize()) {
+        Log(kWarn, "COM1 not found\n");
+        return;
+    }
+    serial_port = port;
+
+    RouteIOAPICInterrupt(kCOM1IRQ, InterruptVector::kSerial, LocalAPICID());
+
+    serial_log_sink = new(serial_log_sink_buf) SerialLogSink;
+    AddLogSink(serial_log_sink);
+}
+
+void PauseSerialLog(bool pause) {
+    if (serial_log_sink) {
+        serial_log_sink->paused = pause;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/** @brief 16550 호환 UART 드라이버.
+ *
+ * 송신은 TX 링에 쌓아 두고, 송신 FIFO가 비었다는 인터럽트(THRE)가 올 때마다
+ * 링에서 최대 FIFO 크기만큼 꺼내 보낸다. 수신한 바이트는 RX 링에 쌓이며 Read로 꺼낸다.
+ * 인터럽트가 금지된 상태(부팅 중 등)에서 Write하면 폴링으로 즉시 송신한다.
+ */
+class SerialPort {
+public:
+    /** @brief 송신 링 크기(바이트). 2의 거듭제곱이어야 한다. */
+    static const size_t kTxRingSize = 8192;
+    /** @brief 수신 링 크기(바이트). 2의 거듭제곱이어야 한다. */
+    static const size_t kRxRingSize = 256;
+
+    explicit SerialPort(uint16_t io_base);
+
+    /** @brief 115200bps 8N1로 포트를 초기화한다.
+     * @return 루프백 검사에 실패하면(포트가 없으면) false
+     */
+    bool Initialize();
+
+    /** @brief 바이트열을 송신 링에 넣는다. 링이 가득 차면 남은 바이트는 버린다.
+     * @return 링에 넣은 바이트 수
+     */
+    size_t Write(const char* s, size_t len);
+
+    /** @brief 송신 링의 빈 자리(바이트). 이만큼은 Write가 버리지 않고 받는다. */
+    size_t TxSpace() const { return kTxRingSize - TxPending(); }
+
+    /** @brief 송신 링이 다 비었을 때 OnInterrupt가 한 번 true를 반환하게 한다.
+     * 링보다 큰 출력을 나눠 보낼 때 다음 조각을 넣도록 메인 루프를 깨우는 데 쓴다.
+     */
+    void NotifyWhenTxEmpty() { __atomic_store_n(&notify_tx_empty_, true, __ATOMIC_RELEASE); }
+
+    /** @brief 수신 링에서 최대 len 바이트를 꺼낸다.
+     * @return 꺼낸 바이트 수
+     */
+    size_t Read(char* buf, size_t len);
+
+    /** @brief 인터럽트 핸들러에서 호출하여 UART의 인터럽트 원인을 처리한다.
+     * @return 수신 링에 새 바이트를 넣었거나, NotifyWhenTxEmpty로 요청한 대로 송신 링이 비었으면 true
+     */
+    bool OnInterrupt();
+
+    /** @brief 송신 링이 가득 차서 버린 바이트의 누적 개수 */
+    uint64_t TxDropped() const { return tx_dropped_; }
+
+private:
+    void EnableTxInterrupt(bool enable);
+    void DrainTx(bool wait_fifo);
+    size_t TxPending() const;
+
+    uint16_t io_base_;
+    uint8_t ier_{0};
+    std::array<char, kTxRingSize> tx_ring_{};
+    size_t tx_head_{0}, tx_tail_{0};
+    std::array<char, kRxRingSize> rx_ring_{};
+    size_t rx_head_{0}, rx_tail_{0};
+    uint64_t tx_dropped_{0};
+    bool notify_tx_empty_{false};
+};
+
+/** @brief COM1. 포트가 없으면 nullptr */
+extern SerialPort* serial_port;
+
+/** @brief COM1 인터럽트를 처리한다. 새로 수신한 바이트가 있거나 요청한 송신 완료 알림이 있으면 true */
+bool SerialOnInterrupt();
+
+/** @brief 시리얼 로그 싱크의 출력을 잠시 멈춘다. 멈춘 동안의 로그는 시리얼로 보내지 않고 버린다.
+ * 이진 덤프 사이에 로그 문자열이 끼어들지 않게 할 때 사용한다.
+ */
+void PauseSerialLog(bool pause);
+
+/** @brief COM1을 초기화하고 로그 싱크로 등록한다. */
+void InitializeSerial();
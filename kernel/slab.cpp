@@ -0,0 +1,225 @@
+#include "slab.hpp"
+
+#include <algorithm>
+
+#include "interrupt.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "memstat.hpp"
+
+namespace {
+    const size_t kCacheLineSize = 64;
+    /** @brief 슬랩 하나에 최소한 담으려는 객체 수 */
+    const size_t kMinObjectsPerSlab = 8;
+    const size_t kMaxSlabFrames = 16;
+    /** @brief 캐시마다 남겨 두는 빈 슬랩의 최대 수. 넘으면 프레임을 반환한다. */
+    const size_t kMaxEmptySlabs = 1;
+
+    SlabCache* first_cache;
+
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+SlabCache::SlabCache(const char* name, size_t object_size, size_t alignment,
+                     void (*ctor)(void*))
+    : name_{name}, object_size_{object_size},
+      alignment_{std::max(alignment, alignof(void*))}, ctor_{ctor},
+      slab_frames_{1}, objects_per_slab_{0}, color_range_{0}, next_color_{0},
+      partial_{nullptr}, full_{nullptr}, empty_{nullptr},
+      num_slabs_{0}, num_empty_{0}, objects_in_use_{0}, allocations_{0}, frees_{0},
+      next_cache_{first_cache} {
+    link_offset_ = ctor_ ? object_size_ : 0;
+    stride_ = AlignUp(std::max(object_size_, sizeof(void*)) + (ctor_ ? sizeof(void*) : 0),
+                      alignment_);
+
+    const size_t header = AlignUp(sizeof(Slab), alignment_);
+    while (true) {
+        const size_t slab_bytes = slab_frames_ * kBytesPerFrame;
+        objects_per_slab_ = (slab_bytes - header) / stride_;
+        if (objects_per_slab_ >= kMinObjectsPerSlab || slab_frames_ == kMaxSlabFrames) {
+            color_range_ = slab_bytes - header - objects_per_slab_ * stride_;
+            break;
+        }
+        slab_frames_ *= 2;
+    }
+
+    first_cache = this;
+}
+
+void* SlabCache::Allocate() {
+    if (partial_ == nullptr) {
+        Slab* slab = empty_;
+        if (slab) {
+            UnlinkSlab(empty_, slab);
+            --num_empty_;
+        } else if ((slab = NewSlab()) == nullptr) {
+            return nullptr;
+        }
+        PushSlab(partial_, slab);
+    }
+
+    Slab* slab = partial_;
+    void* object = slab->free_list;
+    slab->free_list = LinkOf(object);
+    ++slab->in_use;
+    ++objects_in_use_;
+    ++allocations_;
+    if (slab->in_use == objects_per_slab_) {
+        UnlinkSlab(partial_, slab);
+        PushSlab(full_, slab);
+    }
+    return object;
+}
+
+void SlabCache::Free(void* object) {
+    if (object == nullptr) {
+        return;
+    }
+
+    Slab* slab = SlabOf(object);
+    LinkOf(object) = slab->free_list;
+    slab->free_list = object;
+
+    const bool was_full = slab->in_use == objects_per_slab_;
+    --slab->in_use;
+    --objects_in_use_;
+    ++frees_;
+    if (was_full) {
+        UnlinkSlab(full_, slab);
+        PushSlab(partial_, slab);
+    }
+
+    if (slab->in_use == 0) {
+        UnlinkSlab(partial_, slab);
+        if (num_empty_ < kMaxEmptySlabs) {
+            PushSlab(empty_, slab);
+            ++num_empty_;
+        } else {
+            ReleaseSlab(slab);
+        }
+    }
+}
+
+SlabCache::Stats SlabCache::GetStats() const {
+    return {
+        object_size_,
+        objects_in_use_,
+        num_slabs_ * objects_per_slab_,
+        num_slabs_,
+        allocations_,
+        frees_,
+    };
+}
+
+SlabCache::Slab* SlabCache::NewSlab() {
+    // 객체 주소에서 헤더를 찾을 수 있도록 슬랩은 자신의 크기 경계에 맞춘다
+    WithError<FrameID> frame{kNullFrame, MAKE_ERROR(Error::kNoEnoughMemory)};
+    {
+        // 인터럽트 핸들러도 memory_manager를 사용하므로 kmalloc과 같이 인터럽트를 막는다
+        InterruptGuard guard;
+        for (auto zone : kDefaultMemoryZones) {
+            frame = memory_manager->Allocate(slab_frames_, zone, slab_frames_);
+            if (!frame.error) {
+                break;
+            }
+        }
+    }
+    if (frame.error) {
+        return nullptr;
+    }
+    AccountFrames(FrameOwner::kSlab, slab_frames_);
+
+    auto slab = reinterpret_cast<Slab*>(frame.value.Frame());
+    slab->next = slab->prev = nullptr;
+    slab->free_list = nullptr;
+    slab->in_use = 0;
+
+    const size_t color = next_color_;
+    next_color_ = next_color_ + kCacheLineSize <= color_range_ ? next_color_ + kCacheLineSize : 0;
+
+    auto objects = reinterpret_cast<uint8_t*>(slab) + AlignUp(sizeof(Slab), alignment_) + color;
+    for (size_t i = objects_per_slab_; i > 0; --i) {
+        void* object = objects + (i - 1) * stride_;
+        if (ctor_) {
+            ctor_(object);
+        }
+        LinkOf(object) = slab->free_list;
+        slab->free_list = object;
+    }
+
+    ++num_slabs_;
+    return slab;
+}
+
+size_t SlabCache::Shrink() {
+    size_t frames = 0;
+    while (Slab* slab = empty_) {
+        UnlinkSlab(empty_, slab);
+        --num_empty_;
+        ReleaseSlab(slab);
+        frames += slab_frames_;
+    }
+    return frames;
+}
+
+void SlabCache::ReleaseSlab(Slab* slab) {
+    {
+        InterruptGuard guard;
+        memory_manager->Free(FrameID{reinterpret_cast<uintptr_t>(slab) / kBytesPerFrame}, slab_frames_);
+    }
+    AccountFrames(FrameOwner::kSlab, -static_cast<long>(slab_frames_));
+    --num_slabs_;
+}
+
+SlabCache::Slab* SlabCache::SlabOf(void* object) const {
+    const uintptr_t slab_bytes = slab_frames_ * kBytesPerFrame;
+    return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(object) & ~(slab_bytes - 1));
+}
+
+void*& SlabCache::LinkOf(void* object) const {
+    return *reinterpret_cast<void**>(reinterpret_cast<uint8_t*>(object) + link_offset_);
+}
+
+void SlabCache::PushSlab(Slab*& list, Slab* slab) {
+    slab->prev = nullptr;
+    slab->next = list;
+    if (list) {
+        list->prev = slab;
+    }
+    list = slab;
+}
+
+void SlabCache::UnlinkSlab(Slab*& list, Slab* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        list = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = slab->prev = nullptr;
+}
+
+SlabCache* FirstSlabCache() {
+    return first_cache;
+}
+
+void LogSlabStats() {
+    for (auto cache = first_cache; cache != nullptr; cache = cache->Next()) {
+        const auto stats = cache->GetStats();
+        Log(kInfo, "slab %s: size %lu, %lu/%lu objects in %lu slabs, %lu allocs, %lu frees\n",
+            cache->Name(), stats.object_size, stats.objects_in_use, stats.objects_total,
+            stats.slabs, stats.allocations, stats.frees);
+    }
+}
+
+size_t ShrinkSlabCaches() {
+    size_t frames = 0;
+    for (auto cache = first_cache; cache != nullptr; cache = cache->Next()) {
+        frames += cache->Shrink();
+    }
+    return frames;
+}
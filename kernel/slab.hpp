@@ -0,0 +1,169 @@
+/**
+ * @file slab.hpp
+ *
+ * 같은 크기의 커널 객체를 프레임 단위 슬랩에서 잘라 쓰는 슬랩 캐시.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+/** @brief 크기가 고정된 객체를 위한 캐시.
+ * 슬랩은 slab_frames 프레임의 연속 영역이며 자신의 크기 경계에 정렬되어 있어
+ * 객체 주소의 하위 비트를 버리면 슬랩 헤더를 얻는다.
+ * 슬랩마다 객체 시작 위치를 캐시 라인 단위로 어긋나게 하여(coloring) 같은 캐시 세트에 몰리지 않게 한다.
+ * 생성자 ctor를 주면 슬랩을 만들 때 한 번만 호출하고, 반환된 객체는 생성된 상태로 다시 내준다.
+ */
+class SlabCache {
+public:
+    /** @brief 사용 통계 */
+    struct Stats {
+        size_t object_size;
+        size_t objects_in_use;
+        size_t objects_total;
+        size_t slabs;
+        size_t allocations;
+        size_t frees;
+    };
+
+    SlabCache(const char* name, size_t object_size, size_t alignment,
+              void (*ctor)(void*) = nullptr);
+    SlabCache(const SlabCache&) = delete;
+    SlabCache& operator=(const SlabCache&) = delete;
+
+    /** @brief 객체 하나를 할당합니다. 슬랩을 더 만들 수 없으면 nullptr */
+    void* Allocate();
+    /** @brief 이 캐시에서 할당한 객체를 반환합니다. */
+    void Free(void* object);
+    /** @brief 남겨 둔 빈 슬랩을 모두 반환합니다.
+     * @return 반환한 프레임 수
+     */
+    size_t Shrink();
+
+    const char* Name() const { return name_; }
+    Stats GetStats() const;
+    /** @brief 생성된 모든 캐시를 잇는 리스트의 다음 요소 */
+    SlabCache* Next() const { return next_cache_; }
+
+private:
+    struct Slab {
+        Slab* next;
+        Slab* prev;
+        void* free_list;
+        size_t in_use;
+    };
+
+    const char* name_;
+    size_t object_size_;
+    size_t alignment_;
+    void (*ctor_)(void*);
+    /** @brief 슬랩 하나의 프레임 수. 2의 거듭제곱 */
+    size_t slab_frames_;
+    size_t objects_per_slab_;
+    /** @brief 객체 배치 후 남는 바이트. coloring 오프셋의 상한 */
+    size_t color_range_;
+    size_t next_color_;
+
+    Slab* partial_;
+    Slab* full_;
+    Slab* empty_;
+    size_t num_slabs_;
+    size_t num_empty_;
+    size_t objects_in_use_;
+    size_t allocations_;
+    size_t frees_;
+    SlabCache* next_cache_;
+
+    /** @brief 객체 간격. 생성자가 있으면 객체 뒤에 빈 리스트 링크를 둔다 */
+    size_t stride_;
+    /** @brief 객체 선두에서 빈 리스트 링크까지의 오프셋 */
+    size_t link_offset_;
+
+    static void PushSlab(Slab*& list, Slab* slab);
+    static void UnlinkSlab(Slab*& list, Slab* slab);
+    void*& LinkOf(void* object) const;
+    Slab* NewSlab();
+    void ReleaseSlab(Slab* slab);
+    Slab* SlabOf(void* object) const;
+};
+
+/** @brief 생성된 캐시 리스트의 첫 요소 */
+SlabCache* FirstSlabCache();
+/** @brief 모든 슬랩 캐시의 사용 통계를 로그로 출력합니다. */
+void LogSlabStats();
+/** @brief 모든 슬랩 캐시를 Shrink합니다. kmalloc과 공유하므로 인터럽트를 금지한 채 호출해야 합니다.
+ * @return 반환한 프레임 수
+ */
+size_t ShrinkSlabCaches();
+
+/** @brief 타입 T 전용 캐시. 처음 사용할 때 만든다. */
+template <typename T>
+SlabCache& SlabCacheOf() {
+    // 전역 생성자가 호출되지 않으므로 정적 지역 객체 대신 버퍼에 직접 생성한다
+    alignas(SlabCache) static char cache_buf[sizeof(SlabCache)];
+    static SlabCache* cache;
+    if (cache == nullptr) {
+        cache = new(cache_buf) SlabCache{__PRETTY_FUNCTION__, sizeof(T), alignof(T)};
+    }
+    return *cache;
+}
+
+/** @brief 상속하면 new/delete가 T 전용 슬랩 캐시를 사용하게 된다. */
+template <typename T>
+class SlabAllocated {
+public:
+    /** @brief 예외를 쓰지 않으므로 noexcept로 선언해야 할당 실패(nullptr) 시 생성자를 호출하지 않는다. */
+    static void* operator new(size_t size) noexcept {
+        if (size != sizeof(T)) {
+            return ::operator new(size, std::nothrow);
+        }
+        return SlabCacheOf<T>().Allocate();
+    }
+
+    static void operator delete(void* p, size_t size) {
+        if (size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+        SlabCacheOf<T>().Free(p);
+    }
+};
+
+/** @brief 슬랩 캐시를 사용하는 표준 할당자. allocate_shared에 넘겨 제어 블록째 슬랩에 둘 수 있다. */
+template <typename T>
+struct SlabAllocator {
+    using value_type = T;
+
+    SlabAllocator() = default;
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(SlabCacheOf<T>().Allocate());
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        SlabCacheOf<T>().Free(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&) { return false; }
+
+/** @brief make_shared와 같지만 객체와 제어 블록을 슬랩 캐시에서 할당합니다. */
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeSlabShared(Args&&... args) {
+    return std::allocate_shared<T>(SlabAllocator<T>{}, std::forward<Args>(args)...);
+}
@@ -1,7 +1,11 @@
 #include "timer.hpp"
 
 #include <limits>
+#include <cpuid.h>
+#include "acpi.hpp"
+#include "asmfunc.h"
 #include "interrupt.hpp"
+#include "logger.hpp"
 
 namespace {
 
@@ -11,45 +15,391 @@ volatile uint32_t &initial_count = *reinterpret_cast<uint32_t *>(0xfee00380);
 volatile uint32_t &current_count = *reinterpret_cast<uint32_t *>(0xfee00390);
 volatile uint32_t &divide_config = *reinterpret_cast<uint32_t *>(0xfee003e0);
 
+/** @brief 보정에 쓰는 대기 시간. PIT 채널 2의 16비트 카운터로 잴 수 있는 최대(약 54ms) 이하 */
+const unsigned long kCalibrationMilliseconds = 50;
+
+const unsigned long kPITFreq = 1193182;
+const uint16_t kPITChannel2 = 0x42;
+const uint16_t kPITCommand = 0x43;
+const uint16_t kPITGate = 0x61;
+
+/** @brief PIT 채널 2를 원샷으로 돌려 msec 밀리초 동안 바쁜 대기를 합니다. */
+void WaitMillisecondsWithPIT(unsigned long msec) {
+    const uint16_t count = kPITFreq * msec / 1000;
+    const uint8_t gate = IoIn8(kPITGate) & ~0x03u;  // 게이트와 스피커 출력을 끈다
+    IoOut8(kPITGate, gate);
+    IoOut8(kPITCommand, 0b10110000);                // 채널 2, lobyte/hibyte, 모드 0
+    IoOut8(kPITChannel2, count & 0xff);
+    IoOut8(kPITChannel2, count >> 8);
+    IoOut8(kPITGate, gate | 0x01);                  // 게이트를 올려 카운트 시작
+    while ((IoIn8(kPITGate) & 0x20) == 0);          // OUT2가 1이 되면 만료
+    IoOut8(kPITGate, gate);
+}
+
+#ifdef ENABLE_TICKLESS
+const uint32_t kIA32TSCDeadline = 0x6e0;
+
+/** @brief CPU가 LAPIC 타이머의 TSC-deadline 모드를 지원하면 true */
+bool tsc_deadline_mode;
+/** @brief 틱 0에 해당하는 TSC 값 */
+uint64_t tsc_base;
+
+/** @brief TSC 경과 사이클을 틱으로 변환합니다. 곱셈 오버플로를 피하려고 초 단위와 나머지로 나눠 계산한다 */
+unsigned long CyclesToTicks(uint64_t cycles) {
+    return cycles / tsc_freq * kTimerFreq + cycles % tsc_freq * kTimerFreq / tsc_freq;
+}
+
+uint64_t TicksToCycles(unsigned long ticks) {
+    return ticks / kTimerFreq * tsc_freq + ticks % kTimerFreq * tsc_freq / kTimerFreq;
+}
+
+bool HasTSCDeadline() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return ecx & (1u << 24);
+}
+#endif
+
+void WaitMilliseconds(unsigned long msec) {
+    if (acpi::fadt) {
+        acpi::WaitMilliseconds(msec);
+    } else {
+        WaitMillisecondsWithPIT(msec);
+    }
+}
+
 } // namespace
 
-Timer::Timer(unsigned long timeout, int value) : timeout_(timeout), value_(value) {}
+Timer::Timer(unsigned long timeout, int value, unsigned long period)
+    : timeout_(timeout), value_(value), period_(period) {}
 
-void TimerManager::Tick() {
-    ++tick_;
-    while (true) {
-        const auto& t = timers_.top();
-        if (t.Timeout() > tick_) {
+namespace {
+    const unsigned long kNever = std::numeric_limits<unsigned long>::max();
+    const int kSlotBits = 8;
+    const unsigned long kSlotMask = TimerManager::kTimerWheelSlots - 1;
+
+    /** @brief bitmap에서 first 이상인 첫 번째 1비트. 없으면 kTimerWheelSlots */
+    size_t NextSetBit(const std::array<uint64_t, TimerManager::kTimerWheelSlots / 64>& bitmap, size_t first) {
+        for (size_t i = first / 64; i < bitmap.size(); ++i) {
+            uint64_t bits = bitmap[i];
+            if (i == first / 64) {
+                bits &= ~0ul << (first % 64);
+            }
+            if (bits) {
+                return i * 64 + __builtin_ctzl(bits);
+            }
+        }
+        return TimerManager::kTimerWheelSlots;
+    }
+}
+
+TimerManager::TimerManager(MessageQueue &msg_queue) : msg_queue_{msg_queue} {
+    for (size_t i = nodes_.size(); i-- > 0;) {
+        nodes_[i].generation = 1;
+        nodes_[i].next = free_nodes_;
+        free_nodes_ = &nodes_[i];
+    }
+}
+
+void TimerManager::Insert(Node* node) {
+    // 이미 지난 마감은 바로 다음에 처리할 틱에 만료시킨다
+    const unsigned long deadline = node->deadline < wheel_tick_ ? wheel_tick_ : node->deadline;
+    const unsigned long delta = deadline - wheel_tick_;
+
+    Node** head = &overflow_;
+    node->level = kTimerWheelLevels;
+    for (size_t level = 0; level < kTimerWheelLevels; ++level) {
+        if (delta >> (kSlotBits * (level + 1)) == 0) {
+            node->level = level;
+            node->slot = (deadline >> (kSlotBits * level)) & kSlotMask;
+            head = &wheel_[level][node->slot];
+            occupied_[level][node->slot / 64] |= 1ul << (node->slot % 64);
             break;
         }
+    }
 
-        Message m{Message::kTimerTimeout};
-        m.arg.timer.timeout = t.Timeout();
-        m.arg.timer.value = t.Value();
-        msg_queue_.push_back(m);
+    node->prev = nullptr;
+    node->next = *head;
+    if (*head) {
+        (*head)->prev = node;
+    }
+    *head = node;
+}
 
-        timers_.pop();
+void TimerManager::Unlink(Node* node) {
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    if (node->prev) {
+        node->prev->next = node->next;
+        return;
+    }
+
+    if (node->level == kTimerWheelLevels) {
+        overflow_ = node->next;
+        return;
+    }
+    wheel_[node->level][node->slot] = node->next;
+    if (node->next == nullptr) {
+        occupied_[node->level][node->slot / 64] &= ~(1ul << (node->slot % 64));
     }
 }
 
-TimerManager::TimerManager(std::deque<Message> &msg_queue) : msg_queue_{msg_queue} {
-    timers_.push(Timer{std::numeric_limits<unsigned long>::max(), -1});
+void TimerManager::Cascade(size_t level, size_t slot) {
+    Node* node = wheel_[level][slot];
+    wheel_[level][slot] = nullptr;
+    occupied_[level][slot / 64] &= ~(1ul << (slot % 64));
+    while (node) {
+        Node* next = node->next;
+        Insert(node);
+        node = next;
+    }
 }
 
-void TimerManager::AddTimer(const Timer& timer) {
-    timers_.push(timer);
+void TimerManager::Expire(Node* node, unsigned long now) {
+    Message m{Message::kTimerTimeout};
+    m.arg.timer.timeout = node->deadline;
+    m.arg.timer.value = node->value;
+    msg_queue_.Push(m);
+
+    if (node->period != 0) {
+        node->deadline += node->period;
+        if (node->deadline <= now) {
+            // 오래 처리하지 못한 동안 놓친 주기는 한 번으로 합친다
+            node->deadline = now + node->period;
+        }
+        Insert(node);
+        return;
+    }
+
+    Release(node);
+}
+
+void TimerManager::Release(Node* node) {
+    // 풀에 돌려줄 때 세대를 바꿔 이전 핸들을 무효로 만든다. 0은 무효 핸들용으로 건너뛴다
+    if (++node->generation == 0) {
+        node->generation = 1;
+    }
+    node->next = free_nodes_;
+    free_nodes_ = node;
+    --num_pending_;
+}
+
+unsigned long TimerManager::NextDue() const {
+    if (num_pending_ == 0) {
+        return kNever;
+    }
+
+    unsigned long due = kNever;
+    for (size_t level = 0; level < kTimerWheelLevels; ++level) {
+        const int shift = kSlotBits * level;
+        const unsigned long block = wheel_tick_ >> shift;
+        const size_t index = block & kSlotMask;
+        // 윗단의 현재 슬롯은 구간이 시작되는 순간에만 처리하므로, 구간 중간이면 다음 바퀴로 본다
+        const bool at_boundary = level == 0 || (wheel_tick_ & ((1ul << shift) - 1)) == 0;
+        const size_t first = at_boundary ? index : index + 1;
+
+        size_t slot = NextSetBit(occupied_[level], first);
+        unsigned long slot_block;
+        if (slot < kTimerWheelSlots) {
+            slot_block = block - index + slot;
+        } else if (slot = NextSetBit(occupied_[level], 0); slot < first) {
+            slot_block = block - index + kTimerWheelSlots + slot;
+        } else {
+            continue;
+        }
+        const unsigned long slot_start = slot_block << shift;
+        due = slot_start < due ? slot_start : due;
+    }
+
+    if (overflow_) {
+        // 넘침 목록은 최상단이 한 바퀴 돌 때 다시 담는다
+        const int top_shift = kSlotBits * kTimerWheelLevels;
+        const unsigned long wrap = ((wheel_tick_ >> top_shift) + 1) << top_shift;
+        due = wrap < due ? wrap : due;
+    }
+    return due;
+}
+
+void TimerManager::Advance(unsigned long now) {
+    while (true) {
+        const unsigned long t = NextDue();
+        if (t > now) {
+            wheel_tick_ = now + 1;
+            return;
+        }
+        wheel_tick_ = t;
+
+        if ((t & ((1ul << (kSlotBits * kTimerWheelLevels)) - 1)) == 0) {
+            Node* node = overflow_;
+            overflow_ = nullptr;
+            while (node) {
+                Node* next = node->next;
+                Insert(node);
+                node = next;
+            }
+        }
+        // 윗단부터 나눠 담아야 내려온 노드가 같은 틱에 한 번 더 나뉠 수 있다
+        for (size_t level = kTimerWheelLevels - 1; level > 0; --level) {
+            if ((t & ((1ul << (kSlotBits * level)) - 1)) == 0) {
+                Cascade(level, (t >> (kSlotBits * level)) & kSlotMask);
+            }
+        }
+
+        const size_t slot = t & kSlotMask;
+        Node* node = wheel_[0][slot];
+        wheel_[0][slot] = nullptr;
+        occupied_[0][slot / 64] &= ~(1ul << (slot % 64));
+        wheel_tick_ = t + 1;
+        while (node) {
+            Node* next = node->next;
+            Expire(node, now);
+            node = next;
+        }
+    }
+}
+
+void TimerManager::Tick() {
+#ifdef ENABLE_TICKLESS
+    tick_ = CurrentTick();
+#else
+    ++tick_;
+#endif
+    Advance(tick_);
+#ifdef ENABLE_TICKLESS
+    ArmNextDeadline();
+#endif
+}
+
+#ifdef ENABLE_TICKLESS
+unsigned long TimerManager::CurrentTick() const {
+    return CyclesToTicks(ReadTSC() - tsc_base);
+}
+
+void TimerManager::ArmNextDeadline() {
+    const unsigned long deadline = NextDue();
+    armed_deadline_ = deadline;
+    const bool none = deadline == kNever;
+
+    if (tsc_deadline_mode) {
+        // 0을 쓰면 타이머가 멈춘다. 이미 지난 값을 쓰면 곧바로 인터럽트가 온다
+        WriteMSR(kIA32TSCDeadline, none ? 0 : tsc_base + TicksToCycles(deadline));
+        return;
+    }
+
+    if (none) {
+        initial_count = 0;
+        return;
+    }
+    // 원샷 모드: 남은 시간을 LAPIC 카운트로 바꾼다. 1초 넘게 남았으면 1초 뒤에 깨어나 다시 설정한다
+    const unsigned long now = CurrentTick();
+    const unsigned long delta = deadline > now ? deadline - now : 0;
+    const uint64_t clamped = delta < kTimerFreq ? delta : kTimerFreq;
+    uint64_t count = clamped * lapic_timer_freq / kTimerFreq;
+    if (count > kCountMax) {
+        count = kCountMax;
+    }
+    initial_count = count > 0 ? count : 1;
+}
+#endif
+
+TimerHandle TimerManager::AddTimer(const Timer& timer) {
+    InterruptGuard guard;
+    Node* node = free_nodes_;
+    if (node == nullptr) {
+        Log(kWarn, "timer pool exhausted, dropping timer %d\n", timer.Value());
+        return TimerHandle{0, 0};
+    }
+    free_nodes_ = node->next;
+    ++num_pending_;
+
+    node->deadline = timer.Timeout();
+    node->period = timer.Period();
+    node->value = timer.Value();
+    Insert(node);
+
+#ifdef ENABLE_TICKLESS
+    if (timer.Timeout() < armed_deadline_) {
+        ArmNextDeadline();
+    }
+#endif
+    return TimerHandle{static_cast<uint32_t>(node - nodes_.data()), node->generation};
+}
+
+TimerHandle TimerManager::AddTimerAfterMilliseconds(unsigned long msec, int value) {
+    return AddTimer(Timer{CurrentTick() + MillisecondsToTicks(msec), value});
+}
+
+TimerHandle TimerManager::AddTimerAfterMicroseconds(unsigned long usec, int value) {
+    return AddTimer(Timer{CurrentTick() + MicrosecondsToTicks(usec), value});
+}
+
+TimerHandle TimerManager::AddPeriodicTimerMilliseconds(unsigned long msec, int value) {
+    const unsigned long period = MillisecondsToTicks(msec);
+    return AddTimer(Timer{CurrentTick() + period, value, period});
+}
+
+bool TimerManager::CancelTimer(TimerHandle handle) {
+    InterruptGuard guard;
+    if (handle.index >= nodes_.size()) {
+        return false;
+    }
+    Node* node = &nodes_[handle.index];
+    if (!handle.IsValid() || node->generation != handle.generation) {
+        return false;
+    }
+
+    Unlink(node);
+    Release(node);
+    return true;
+}
+
+unsigned long TimerManager::NextDeadline() const {
+    InterruptGuard guard;
+    return NextDue();
 }
 
 TimerManager* timer_manager;
+unsigned long lapic_timer_freq;
+uint64_t tsc_freq;
 
 void LAPICTimerOnInterrupt() {
     timer_manager->Tick();
 }
 
-void InitializeLAPICTimer(std::deque<Message>& msg_queue) {
+void InitializeLAPICTimer(MessageQueue& msg_queue) {
     timer_manager = new TimerManager{msg_queue};
 
     divide_config = 0b1011;         // divide 1:1
+    lvt_timer = (0b001 << 16);      // masked, one-shot
+
+    // 알려진 시간 동안 LAPIC 타이머와 TSC가 얼마나 진행하는지 잰다
+    const uint64_t tsc_start = ReadTSC();
+    initial_count = kCountMax;
+    WaitMilliseconds(kCalibrationMilliseconds);
+    const uint32_t elapsed = kCountMax - current_count;
+    const uint64_t tsc_elapsed = ReadTSC() - tsc_start;
+    initial_count = 0;
+
+    lapic_timer_freq = static_cast<unsigned long>(elapsed) * 1000 / kCalibrationMilliseconds;
+    tsc_freq = tsc_elapsed * 1000 / kCalibrationMilliseconds;
+    Log(kInfo, "LAPIC timer %lu Hz, TSC %lu Hz (calibrated with %s)\n",
+        lapic_timer_freq, tsc_freq, acpi::fadt ? "ACPI PM timer" : "PIT");
+
+#ifdef ENABLE_TICKLESS
+    tsc_deadline_mode = HasTSCDeadline();
+    tsc_base = ReadTSC();
+    if (tsc_deadline_mode) {
+        lvt_timer = (0b100 << 16) | InterruptVector::kLAPICTimer; // not-masked, TSC-deadline
+    } else {
+        lvt_timer = InterruptVector::kLAPICTimer;                 // not-masked, one-shot
+    }
+    // 보초 타이머만 있으므로 AddTimer가 처음 불릴 때까지 타이머를 설정하지 않는다
+    Log(kInfo, "tickless timer in %s mode\n", tsc_deadline_mode ? "TSC-deadline" : "one-shot");
+#else
     lvt_timer = (0b010 << 16) | InterruptVector::kLAPICTimer; // not-masked, periodic
-    initial_count = 0x1000000u;
+    initial_count = lapic_timer_freq / kTimerFreq;
+#endif
 }
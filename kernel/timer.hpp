@@ -1,39 +1,167 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <queue>
-#include <deque>
-#include "message.hpp"
+#include <limits>
+#include "message_queue.hpp"
 
+#ifdef ENABLE_TICKLESS
+/** @brief 1초당 틱 수. 틱리스 모드에서는 주기 인터럽트가 없으므로 1틱 = 1us로 둔다 */
+const unsigned long kTimerFreq = 1'000'000;
+#else
+/** @brief 1초당 틱 수. LAPIC 타이머를 이 주기로 인터럽트하도록 보정한다(1틱 = 1ms) */
+const unsigned long kTimerFreq = 1000;
+#endif
+
+/** @brief 보정한 LAPIC 타이머 카운터의 주파수(Hz, 분주 1:1) */
+extern unsigned long lapic_timer_freq;
+/** @brief 보정한 TSC 주파수(Hz) */
+extern uint64_t tsc_freq;
+
+/** @brief 밀리초를 틱으로 변환합니다. 올림합니다. */
+inline unsigned long MillisecondsToTicks(unsigned long msec) {
+    return (msec * kTimerFreq + 999) / 1000;
+}
+
+/** @brief 마이크로초를 틱으로 변환합니다. 올림하므로 1틱보다 짧은 시간도 1틱이 됩니다. */
+inline unsigned long MicrosecondsToTicks(unsigned long usec) {
+    return (usec * kTimerFreq + 999'999) / 1'000'000;
+}
+
+/** @brief 틱을 밀리초로 변환합니다. */
+inline unsigned long TicksToMilliseconds(unsigned long ticks) {
+    return ticks * 1000 / kTimerFreq;
+}
+
+/** @brief 마이크로초를 TSC 사이클 수로 변환합니다. */
+inline uint64_t MicrosecondsToCycles(uint64_t usec) {
+    return usec * (tsc_freq / 1'000'000);
+}
+
+/** @brief 타이머의 마감 틱과 만료 메시지에 실을 값. period가 0이 아니면 그 틱 간격으로 반복한다 */
 class Timer {
 public:
-    Timer(unsigned long timeout, int value);
+    Timer(unsigned long timeout, int value, unsigned long period = 0);
     unsigned long Timeout() const { return timeout_; }
     int Value() const { return value_; }
-
-    inline bool operator< (const Timer& rhs) const {
-        return this->Timeout() > rhs.Timeout();
-    }
+    unsigned long Period() const { return period_; }
 
 private:
     unsigned long timeout_;
     int value_;
+    unsigned long period_;
 };
 
+/** @brief 추가한 타이머를 가리키는 핸들. 만료되거나 취소된 뒤의 핸들은 무효가 된다 */
+struct TimerHandle {
+    uint32_t index;
+    /** @brief 노드를 재사용할 때마다 증가한다. 0은 무효 핸들 */
+    uint32_t generation;
+
+    bool IsValid() const { return generation != 0; }
+};
+
+/** @brief 타이머 목록을 관리하고 만료된 타이머를 메시지로 알리는 클래스.
+ *
+ * 타이머는 미리 할당한 노드 풀에 담아 계층형 타이밍 휠에 매단다.
+ * 휠은 kTimerWheelSlots개의 슬롯을 가진 kTimerWheelLevels단으로, 단 L은 마감까지
+ * 256^L 이상 256^(L+1) 미만 틱 남은 타이머를 (마감 >> 8L) % 256 슬롯에 둔다.
+ * 윗단 슬롯은 그 구간이 시작될 때 아랫단으로 다시 나눠 담는다(cascade).
+ * 추가, 취소, 만료가 모두 O(1)이며 메모리를 할당하지 않는다.
+ * 휠에 담을 수 없을 만큼 먼 타이머는 넘침 목록에 두었다가 최상단이 한 바퀴 돌 때 다시 담는다.
+ *
+ * ENABLE_TICKLESS가 없으면 LAPIC 타이머가 1틱마다 주기 인터럽트를 일으켜 Tick을 호출한다.
+ * ENABLE_TICKLESS면 다음 처리 시각에만 인터럽트가 오도록 TSC-deadline 모드(없으면 원샷 모드)로
+ * 타이머를 다시 설정하며, CurrentTick은 TSC에서 필요할 때 계산한다.
+ */
 class TimerManager {
 public:
-    TimerManager(std::deque<Message>& msg_queue);
+    /** @brief 동시에 걸어 둘 수 있는 타이머의 최대 수 */
+    static const size_t kMaxTimers = 4096;
+    static const size_t kTimerWheelLevels = 4;
+    static const size_t kTimerWheelSlots = 256;
+
+    TimerManager(MessageQueue& msg_queue);
+    /** @brief LAPIC 타이머 인터럽트에서 호출하여 만료된 타이머를 처리합니다. */
     void Tick();
+#ifdef ENABLE_TICKLESS
+    unsigned long CurrentTick() const;
+#else
     unsigned long CurrentTick() const { return tick_; }
-    void AddTimer(const Timer& timer);
+#endif
+    /** @brief 타이머를 추가합니다. 틱리스 모드에서는 다음 처리 시각이 앞당겨지면 타이머를 다시 설정합니다.
+     * @return 취소에 쓸 핸들. 노드 풀이 가득 차면 무효 핸들
+     */
+    TimerHandle AddTimer(const Timer& timer);
+    /** @brief 지금부터 msec 밀리초 뒤에 만료되는 타이머를 추가합니다. */
+    TimerHandle AddTimerAfterMilliseconds(unsigned long msec, int value);
+    /** @brief 지금부터 usec 마이크로초 뒤에 만료되는 타이머를 추가합니다. 틱 단위로 올림합니다. */
+    TimerHandle AddTimerAfterMicroseconds(unsigned long usec, int value);
+    /** @brief msec 밀리초마다 반복해서 만료되는 타이머를 추가합니다. */
+    TimerHandle AddPeriodicTimerMilliseconds(unsigned long msec, int value);
+    /** @brief 아직 만료되지 않은 타이머를 취소합니다.
+     * @return 취소했으면 true. 이미 만료되었거나 취소된 핸들이면 false
+     */
+    bool CancelTimer(TimerHandle handle);
+    /** @brief 휠을 다음에 처리해야 하는 틱. 윗단 슬롯을 나눠 담는 시각일 수 있으므로 실제 마감 이하이다.
+     * 타이머가 없으면 unsigned long의 최댓값
+     */
+    unsigned long NextDeadline() const;
+    /** @brief 걸려 있는 타이머 수 */
+    size_t PendingTimers() const { return num_pending_; }
 
 private:
+    struct Node {
+        Node* prev;
+        Node* next;
+        unsigned long deadline;
+        unsigned long period;
+        int value;
+        uint32_t generation;
+        /** @brief 매달린 단. kTimerWheelLevels면 넘침 목록 */
+        uint8_t level;
+        uint8_t slot;
+    };
+
     volatile unsigned long tick_{0};
-    std::priority_queue<Timer> timers_{};
-    std::deque<Message>& msg_queue_;
+    /** @brief 아직 처리하지 않은 가장 이른 틱 */
+    unsigned long wheel_tick_{0};
+    std::array<Node, kMaxTimers> nodes_;
+    Node* free_nodes_{nullptr};
+    size_t num_pending_{0};
+    std::array<std::array<Node*, kTimerWheelSlots>, kTimerWheelLevels> wheel_{};
+    /** @brief 단마다 비어 있지 않은 슬롯을 나타내는 비트맵 */
+    std::array<std::array<uint64_t, kTimerWheelSlots / 64>, kTimerWheelLevels> occupied_{};
+    Node* overflow_{nullptr};
+
+    /** @brief node를 마감까지 남은 틱에 맞는 단과 슬롯에 매답니다. */
+    void Insert(Node* node);
+    /** @brief node를 매달린 목록에서 뗍니다. */
+    void Unlink(Node* node);
+    /** @brief 단 level의 slot 슬롯에 매달린 노드를 모두 떼어 다시 담습니다. */
+    void Cascade(size_t level, size_t slot);
+    /** @brief node를 풀에 돌려줍니다. */
+    void Release(Node* node);
+    /** @brief 만료된 node를 알리고, 주기 타이머면 다시 담고 아니면 풀에 돌려줍니다. */
+    void Expire(Node* node, unsigned long now);
+    /** @brief now까지의 모든 틱을 처리합니다. 할 일이 없는 틱은 건너뜁니다. */
+    void Advance(unsigned long now);
+    /** @brief wheel_tick_ 이후 슬롯을 처리해야 하는 가장 이른 틱 */
+    unsigned long NextDue() const;
+#ifdef ENABLE_TICKLESS
+    /** @brief LAPIC 타이머에 설정해 둔 처리 시각 */
+    unsigned long armed_deadline_{std::numeric_limits<unsigned long>::max()};
+    /** @brief 휠의 다음 처리 시각으로 LAPIC 타이머를 설정합니다. 인터럽트 금지 상태에서 호출해야 합니다. */
+    void ArmNextDeadline();
+#endif
+    MessageQueue& msg_queue_;
 };
 
 extern TimerManager* timer_manager;
 
 void LAPICTimerOnInterrupt();
-void InitializeLAPICTimer(std::deque<Message>& msg_queue);
\ No newline at end of file
+/** @brief LAPIC 타이머와 TSC를 ACPI PM 타이머(없으면 PIT)로 보정하고
+ * kTimerFreq 주기의 인터럽트를 시작합니다. acpi::Initialize 뒤에 호출해야 합니다.
+ */
+void InitializeLAPICTimer(MessageQueue& msg_queue);
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "trace.hpp"
+
+#include "logger.hpp"
+#include "serial.hpp"
+#include "timer.hpp"
+
+#ifdef ENABLE_TRACE
+std::array<TraceBuffer, kTraceMaxCPUs> trace_buffers;
+#endif
+
+namespace {
+    /** @brief 덤프 출력의 머리. 뒤이어 num_cpus개의 CPU마다 head(8바이트)와 min(head, records_per_cpu)개의 레코드가 온다. */
+    struct TraceDumpHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t num_cpus;
+        uint32_t records_per_cpu;
+        /** @brief TSC 주파수(Hz). 알 수 없으면 0 */
+        uint64_t tsc_hz;
+    } __attribute__((packed));
+
+    /** @brief 덤프 출력을 이루는 연속된 바이트 구간 */
+    struct DumpSection {
+        const char* data;
+        size_t len;
+    };
+
+    /** @brief 진행 중인 덤프. port가 nullptr이면 덤프 중이 아니다. */
+    struct TraceDumpState {
+        SerialPort* port;
+        TraceDumpHeader header;
+        /** @brief 덤프를 시작할 때 읽어 둔 각 CPU의 head */
+        std::array<uint64_t, kTraceMaxCPUs> heads;
+        /** @brief 머리, 그리고 CPU마다 head와 레코드 배열 */
+        std::array<DumpSection, 1 + 2 * kTraceMaxCPUs> sections;
+        size_t num_sections;
+        /** @brief 보내고 있는 구간과 그 안에서 이미 보낸 바이트 수 */
+        size_t section;
+        size_t offset;
+    };
+
+    TraceDumpState dump;
+
+    template <typename T>
+    void AddSection(const T* data, size_t len) {
+        dump.sections[dump.num_sections++] = {reinterpret_cast<const char*>(data), len};
+    }
+}
+
+void StartTraceDump(SerialPort& port) {
+#ifdef ENABLE_TRACE
+    if (dump.port) {
+        return;   // 이미 보내는 중
+    }
+
+    dump.header = TraceDumpHeader{
+        {'M', 'I', 'K', 'T', 'R', 'A', 'C', 'E'},
+        2, sizeof(TraceRecord), 0, kTraceRecordsPerCPU, tsc_freq,
+    };
+    dump.num_sections = 0;
+    AddSection(&dump.header, sizeof(dump.header));
+    for (unsigned int cpu = 0; cpu < kTraceMaxCPUs; ++cpu) {
+        const uint64_t head = __atomic_load_n(&trace_buffers[cpu].head, __ATOMIC_RELAXED);
+        if (head == 0) {
+            continue;
+        }
+        const uint64_t count = head < kTraceRecordsPerCPU ? head : kTraceRecordsPerCPU;
+        dump.heads[cpu] = head;
+        AddSection(&dump.heads[cpu], sizeof(uint64_t));
+        AddSection(trace_buffers[cpu].records.data(), count * sizeof(TraceRecord));
+        ++dump.header.num_cpus;
+    }
+    dump.section = 0;
+    dump.offset = 0;
+    dump.port = &port;
+    PauseSerialLog(true);
+#else
+    Log(kWarn, "trace is disabled. rebuild with ENABLE_TRACE=1\n");
+#endif
+}
+
+void ContinueTraceDump() {
+    if (dump.port == nullptr) {
+        return;
+    }
+
+    while (dump.section < dump.num_sections) {
+        const auto& section = dump.sections[dump.section];
+        const size_t space = dump.port->TxSpace();
+        if (space == 0) {
+            // 송신 인터럽트가 링을 비우면 메인 루프를 깨워 이어 보낸다
+            dump.port->NotifyWhenTxEmpty();
+            return;
+        }
+        const size_t len = section.len - dump.offset < space ? section.len - dump.offset : space;
+        dump.port->Write(section.data + dump.offset, len);
+        dump.offset += len;
+        if (dump.offset == section.len) {
+            ++dump.section;
+            dump.offset = 0;
+        }
+    }
+
+    dump.port = nullptr;
+    PauseSerialLog(false);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "asmfunc.h"
+#include "interrupt.hpp"
+
+class SerialPort;
+
+enum TraceEventID : uint16_t {
+#define TRACE_EVENT(name, ...) kTrace##name,
+#include "trace_events.def"
+#undef TRACE_EVENT
+    kTraceEventCount
+};
+
+/** @brief 한 트레이스 레코드가 담을 수 있는 최대 인자 수 */
+const int kTraceMaxArgs = 6;
+/** @brief CPU별 트레이스 버퍼의 레코드 수. 2의 거듭제곱이어야 한다. */
+const uint64_t kTraceRecordsPerCPU = 4096;
+/** @brief 트레이스 버퍼를 가지는 최대 CPU 수 */
+const unsigned int kTraceMaxCPUs = 4;
+
+/** @brief 트레이스 이벤트 1건. 인자는 서식하지 않은 원시 값으로 보관한다. */
+struct TraceRecord {
+    uint64_t tsc;
+    uint16_t id;
+    uint8_t cpu;
+    uint8_t num_args;
+    uint32_t reserved;
+    uint64_t args[kTraceMaxArgs];
+};
+static_assert(sizeof(TraceRecord) == 64);
+
+/** @brief CPU 하나의 트레이스 링. 가득 차면 가장 오래된 레코드를 덮어쓴다. */
+struct alignas(64) TraceBuffer {
+    /** @brief 지금까지 기록된 레코드 수. 다음 기록 위치는 head % kTraceRecordsPerCPU */
+    uint64_t head;
+    std::array<TraceRecord, kTraceRecordsPerCPU> records;
+};
+
+#ifdef ENABLE_TRACE
+
+extern std::array<TraceBuffer, kTraceMaxCPUs> trace_buffers;
+
+template <typename T>
+inline uint64_t ToTraceArg(T value) {
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uintptr_t>(value);
+    } else {
+        return static_cast<uint64_t>(value);
+    }
+}
+
+inline unsigned int CurrentTraceCPU() {
+    return LocalAPICID() % kTraceMaxCPUs;
+}
+
+/** @brief TRACE 매크로의 실체. 슬롯을 원자적으로 확보하므로 인터럽트 핸들러에서도 안전하다. */
+template <typename... Args>
+inline void TraceRecordEvent(TraceEventID id, Args... args) {
+    static_assert(sizeof...(Args) <= kTraceMaxArgs, "too many trace arguments");
+
+    const unsigned int cpu = CurrentTraceCPU();
+    auto& buf = trace_buffers[cpu];
+    const uint64_t pos = __atomic_fetch_add(&buf.head, 1, __ATOMIC_RELAXED);
+    auto& record = buf.records[pos % kTraceRecordsPerCPU];
+
+    record.tsc = ReadTSC();
+    record.id = id;
+    record.cpu = cpu;
+    record.num_args = sizeof...(Args);
+    int i = 0;
+    ((record.args[i++] = ToTraceArg(args)), ...);
+}
+
+/** @brief 정적 트레이스 포인트. ENABLE_TRACE가 정의되지 않으면 인자까지 포함해 아무 코드도 생성하지 않는다. */
+#define TRACE(name, ...) TraceRecordEvent(kTrace##name, ##__VA_ARGS__)
+
+#else
+
+#define TRACE(name, ...) ((void)0)
+
+#endif
+
+/**
+ * @brief 트레이스 버퍼를 이진 형식 그대로 시리얼 포트로 보내기 시작한다.
+ * 출력은 "MIKTRACE" 매직으로 시작하며 tools/tracedecode.py가 Chrome trace JSON으로 변환한다.
+ * 기록이 있는 CPU의 버퍼만, 그중 유효한 레코드만 보낸다.
+ * 실제 송신은 ContinueTraceDump가 송신 링의 빈 자리만큼씩 이어 간다.
+ * 덤프가 끝날 때까지 시리얼 로그는 버려진다. 덤프 중에 기록된 이벤트는 아직 보내지 않은 레코드를 덮어쓸 수 있다.
+ */
+void StartTraceDump(SerialPort& port);
+
+/**
+ * @brief 진행 중인 트레이스 덤프를 송신 링이 받는 만큼 이어 보낸다. 메인 루프에서 인터럽트를 허용한 채 호출한다.
+ * 보낼 것이 남았으면 송신 링이 빌 때 kSerialInput 메시지로 다시 깨어나도록 요청한다.
+ */
+void ContinueTraceDump();
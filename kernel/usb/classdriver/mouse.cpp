@@ -4,6 +4,7 @@
 #include "usb/memory.hpp"
 #include "usb/device.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
 
 namespace usb {
   HIDMouseDriver::HIDMouseDriver(Device* dev, int interface_index)
@@ -15,7 +16,7 @@ namespace usb {
     int8_t displacement_x = Buffer()[1];
     int8_t displacement_y = Buffer()[2];
     NotifyMouseMove(buttons, displacement_x, displacement_y);
-    Log(kDebug, "%02x,(%3d,%3d)\n", buttons, displacement_x, displacement_y);
+    TRACE(HIDMouseData, buttons, displacement_x, displacement_y);
     return MAKE_ERROR(Error::kSuccess);
   }
 
@@ -83,7 +83,7 @@ namespace {
   void Log(LogLevel level, const usb::EndpointConfig& conf) {
     Log(level, "EndpointConf: ep_id=%d, ep_type=%d"
         ", max_packet_size=%d, interval=%d\n",
-        conf.ep_id.Address(), conf.ep_type,
+        conf.ep_id.Address(), static_cast<int>(conf.ep_type),
         conf.max_packet_size, conf.interval);
   }
 
@@ -102,6 +102,19 @@ namespace {
 
 namespace usb {
   Device::~Device() {
+    // 1 つのクラスドライバが複数のエンドポイントに登録されていることがある
+    for (size_t i = 0; i < class_drivers_.size(); ++i) {
+      auto class_driver = class_drivers_[i];
+      if (class_driver == nullptr) {
+        continue;
+      }
+      for (size_t j = i; j < class_drivers_.size(); ++j) {
+        if (class_drivers_[j] == class_driver) {
+          class_drivers_[j] = nullptr;
+        }
+      }
+      delete class_driver;
+    }
   }
 
   Error Device::ControlIn(EndpointID ep_id, SetupData setup_data,
@@ -148,7 +161,7 @@ namespace usb {
 
   Error Device::OnControlCompleted(EndpointID ep_id, SetupData setup_data,
                                    const void* buf, int len) {
-    Log(kDebug, "Device::OnControlCompleted: buf 0x%08x, len %d, dir %d\n",
+    Log(kDebug, "Device::OnControlCompleted: buf %p, len %d, dir %d\n",
         buf, len, setup_data.request_type.bits.direction);
     if (is_initialized_) {
       if (auto w = event_waiters_.Get(setup_data)) {
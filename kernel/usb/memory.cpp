@@ -1,43 +1,213 @@
 #include "usb/memory.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "logger.hpp"
+#include "zero_pool.hpp"
 
 namespace {
-  template <class T>
-  T Ceil(T value, unsigned int alignment) {
-    return (value + alignment - 1) & ~static_cast<T>(alignment - 1);
+  const size_t kFrameBytes = 4096;
+  const size_t kMinBlockSize = 64;
+
+  /** @brief value 以上の最小の 2 の冪 */
+  size_t RoundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
   }
 
-  template <class T, class U>
-  T MaskBits(T value, U mask) {
-    return value & ~static_cast<T>(mask - 1);
+  /** @brief プールに収まらない領域．フレーム単位で確保する */
+  struct LargeBlock {
+    LargeBlock* next;
+    uintptr_t base;
+    size_t num_frames;
+  };
+  LargeBlock* large_blocks;
+
+  /** @brief ブロックの大きさ 64, 128, ..., DMAPool::kMaxBlockSize ごとのプール */
+  const size_t kNumPools = 6;
+  static_assert(kMinBlockSize << (kNumPools - 1) == usb::DMAPool::kMaxBlockSize);
+  alignas(usb::DMAPool) char pool_buf[kNumPools][sizeof(usb::DMAPool)];
+  usb::DMAPool* pools[kNumPools];
+
+  usb::DMAPool& PoolFor(size_t block_size) {
+    size_t i = 0;
+    while ((kMinBlockSize << i) < block_size) {
+      ++i;
+    }
+    if (pools[i] == nullptr) {
+      pools[i] = new(pool_buf[i]) usb::DMAPool{kMinBlockSize << i};
+    }
+    return *pools[i];
+  }
+
+  WithError<FrameID> AllocateDMAFrames(size_t num_frames, size_t alignment) {
+    return AllocateFrames(num_frames, MemoryZone::kDMA32, alignment, FrameOwner::kUSB, true);
   }
 }
 
 namespace usb {
-  alignas(64) uint8_t memory_pool[kMemoryPoolSize];
-  uintptr_t alloc_ptr = reinterpret_cast<uintptr_t>(memory_pool);
+  /** @brief プールが切り出しているフレーム 1 つ分の管理情報 */
+  struct DMAPool::Page {
+    Page* next;
+    uintptr_t base;
+    /** @brief ビット i が 1 ならブロック i は空き */
+    uint64_t free_map;
+    /** @brief ビット i が 1 ならブロック i は一度貸し出されており，0 で初期化し直す必要がある */
+    uint64_t dirty_map;
+  };
 
-  void* AllocMem(size_t size, unsigned int alignment, unsigned int boundary) {
-    if (alignment > 0) {
-      alloc_ptr = Ceil(alloc_ptr, alignment);
+  DMAPool::DMAPool(size_t block_size) : block_size_{block_size} {
+  }
+
+  void* DMAPool::Allocate() {
+    const size_t blocks_per_page = kFrameBytes / block_size_;
+    const uint64_t full_map = blocks_per_page == 64 ? ~uint64_t{0} : (uint64_t{1} << blocks_per_page) - 1;
+
+    Page* page = pages_;
+    while (page != nullptr && page->free_map == 0) {
+      page = page->next;
+    }
+    if (page == nullptr) {
+      const auto frame = AllocateDMAFrames(1, 1);
+      if (frame.error) {
+        return nullptr;
+      }
+      // フレームは 0 で初期化済みなので，各ブロックは最初の貸し出しでは消去しなくてよい
+      page = new Page{pages_, reinterpret_cast<uintptr_t>(frame.value.Frame()), full_map, 0};
+      pages_ = page;
+      ++empty_pages_;
+    }
+
+    if (page->free_map == full_map) {
+      --empty_pages_;
+    }
+    // 未使用のブロックを優先し，キャッシュ経由の消去を再利用時だけにする
+    const uint64_t clean_map = page->free_map & ~page->dirty_map;
+    const int index = __builtin_ctzll(clean_map ? clean_map : page->free_map);
+    const uint64_t bit = uint64_t{1} << index;
+    page->free_map &= ~bit;
+    auto p = reinterpret_cast<void*>(page->base + index * block_size_);
+    if (page->dirty_map & bit) {
+      memset(p, 0, block_size_);
+    }
+    page->dirty_map |= bit;
+    return p;
+  }
+
+  bool DMAPool::Free(void* p) {
+    const auto addr = reinterpret_cast<uintptr_t>(p);
+    const size_t blocks_per_page = kFrameBytes / block_size_;
+    const uint64_t full_map = blocks_per_page == 64 ? ~uint64_t{0} : (uint64_t{1} << blocks_per_page) - 1;
+
+    Page** link = &pages_;
+    while (*link != nullptr && (*link)->base != (addr & ~(kFrameBytes - 1))) {
+      link = &(*link)->next;
+    }
+    Page* page = *link;
+    if (page == nullptr) {
+      return false;
+    }
+
+    page->free_map |= uint64_t{1} << ((addr - page->base) / block_size_);
+    if (page->free_map != full_map) {
+      return true;
+    }
+
+    // 空きフレームは 1 つだけ残し，それ以外はメインのアロケータへ返す
+    if (empty_pages_ == 0) {
+      ++empty_pages_;
+      return true;
+    }
+    *link = page->next;
+    FreeFrames(FrameID{page->base / kFrameBytes}, 1, FrameOwner::kUSB);
+    delete page;
+    return true;
+  }
+
+  size_t DMAPool::BytesInUse() const {
+    const size_t blocks_per_page = kFrameBytes / block_size_;
+    size_t blocks = 0;
+    for (Page* page = pages_; page != nullptr; page = page->next) {
+      blocks += blocks_per_page - __builtin_popcountll(page->free_map);
+    }
+    return blocks * block_size_;
+  }
+
+  size_t DMAPool::BytesReserved() const {
+    size_t pages = 0;
+    for (Page* page = pages_; page != nullptr; page = page->next) {
+      ++pages;
     }
-    if (boundary > 0) {
-      auto next_boundary = Ceil(alloc_ptr, boundary);
-      if (next_boundary < alloc_ptr + size) {
-        alloc_ptr = next_boundary;
+    return pages * kFrameBytes;
+  }
+
+  DMAPoolUsage GetDMAPoolUsage() {
+    DMAPoolUsage usage{0, 0, 0};
+    for (auto pool : pools) {
+      if (pool) {
+        usage.pool_bytes_in_use += pool->BytesInUse();
+        usage.pool_bytes_reserved += pool->BytesReserved();
       }
     }
+    for (LargeBlock* block = large_blocks; block != nullptr; block = block->next) {
+      usage.large_bytes += block->num_frames * kFrameBytes;
+    }
+    return usage;
+  }
+
+  void* AllocMem(size_t size, unsigned int alignment, unsigned int boundary) {
+    if (size == 0) {
+      size = 1;
+    }
 
-    if (reinterpret_cast<uintptr_t>(memory_pool) + kMemoryPoolSize
-        < alloc_ptr + size) {
+    // 2 の冪の大きさのブロックは大きさに自然に揃うので，
+    // size 以上 alignment 以上にすれば両方の制約を満たす（boundary は 4096 の倍数を想定）
+    const size_t block_size = RoundUpPowerOfTwo(std::max<size_t>(size, alignment));
+    if (boundary != 0 && boundary < kFrameBytes && block_size > boundary) {
+      Log(kError, "usb::AllocMem: boundary %u is too small for %lu bytes\n", boundary, size);
       return nullptr;
     }
 
-    auto p = alloc_ptr;
-    alloc_ptr += size;
-    return reinterpret_cast<void*>(p);
+    if (block_size <= DMAPool::kMaxBlockSize) {
+      return PoolFor(std::max(block_size, kMinBlockSize)).Allocate();
+    }
+
+    const size_t num_frames = (block_size + kFrameBytes - 1) / kFrameBytes;
+    const auto frame = AllocateDMAFrames(num_frames, num_frames);
+    if (frame.error) {
+      return nullptr;
+    }
+    const auto base = reinterpret_cast<uintptr_t>(frame.value.Frame());
+    large_blocks = new LargeBlock{large_blocks, base, num_frames};
+    return reinterpret_cast<void*>(base);
   }
 
-  void FreeMem(void* p) {}
+  void FreeMem(void* p) {
+    if (p == nullptr) {
+      return;
+    }
+
+    for (auto pool : pools) {
+      if (pool && pool->Free(p)) {
+        return;
+      }
+    }
+
+    for (LargeBlock** link = &large_blocks; *link != nullptr; link = &(*link)->next) {
+      LargeBlock* block = *link;
+      if (block->base == reinterpret_cast<uintptr_t>(p)) {
+        *link = block->next;
+        FreeFrames(FrameID{block->base / kFrameBytes}, block->num_frames, FrameOwner::kUSB);
+        delete block;
+        return;
+      }
+    }
+    Log(kError, "usb::FreeMem: %p was not allocated by AllocMem\n", p);
+  }
 }
@@ -9,14 +9,58 @@
 #include <cstddef>
 
 namespace usb {
-  /** @brief 動的メモリ確保のためのメモリプールの最大容量（バイト） */
-  static const size_t kMemoryPoolSize = 4096 * 32;
+  /** @brief 同じ大きさのブロックを DMA32 ゾーンのフレームから切り出すメモリプール．
+   *
+   * Linux の dma_pool に相当する．ブロックの大きさは 2 の冪で，ブロックは
+   * その大きさに自然に揃う．したがって block_size 以下のアライメントと，
+   * 4096 の倍数である任意の境界を満たす．
+   * 全ブロックが空いたフレームは，空きフレームを 1 つだけ残してメインのアロケータへ返す．
+   */
+  class DMAPool {
+   public:
+    /** @brief block_size は 2 の冪で，64 以上 kMaxBlockSize 以下 */
+    explicit DMAPool(size_t block_size);
+    DMAPool(const DMAPool&) = delete;
+    DMAPool& operator=(const DMAPool&) = delete;
+
+    /** @brief 0 で初期化したブロックを確保する．確保できなかった場合は nullptr */
+    void* Allocate();
+    /** @brief p がこのプールのブロックなら解放して true を返す */
+    bool Free(void* p);
+    size_t BlockSize() const { return block_size_; }
+    /** @brief 使用中のブロックの合計バイト数 */
+    size_t BytesInUse() const;
+    /** @brief プールが保持しているフレームの合計バイト数 */
+    size_t BytesReserved() const;
+
+    /** @brief プールが扱うブロックの最大の大きさ．これより大きい領域はフレーム単位で確保する */
+    static const size_t kMaxBlockSize = 2048;
+
+   private:
+    struct Page;
+
+    const size_t block_size_;
+    Page* pages_ = nullptr;
+    /** @brief 全ブロックが空いているフレームの数 */
+    size_t empty_pages_ = 0;
+  };
+
+  /** @brief AllocMem が使用しているメモリの集計 */
+  struct DMAPoolUsage {
+    size_t pool_bytes_in_use;
+    size_t pool_bytes_reserved;
+    /** @brief プールに収まらずフレーム単位で確保した領域の合計バイト数 */
+    size_t large_bytes;
+  };
+
+  DMAPoolUsage GetDMAPoolUsage();
 
   /** @brief 指定されたバイト数のメモリ領域を確保して先頭ポインタを返す．
    *
    * 先頭アドレスが alignment に揃ったメモリ領域を確保する．
    * size <= boundary ならメモリ領域が boundary を跨がないことを保証する．
    * boundary は典型的にはページ境界を跨がないように 4096 を指定する．
+   * 領域は DMA32 ゾーンのフレームから確保され，0 で初期化される．
    *
    * @param size        確保するメモリ領域のサイズ（バイト単位）
    * @param alignment   メモリ領域のアライメント制約．0 なら制約しない．
@@ -31,7 +75,7 @@ namespace usb {
         AllocMem(sizeof(T) * num_obj, alignment, boundary));
   }
 
-  /** @brief 指定されたメモリ領域を解放する．本当に解放することは保証されない． */
+  /** @brief AllocMem で確保したメモリ領域を解放する．nullptr なら何もしない． */
   void FreeMem(void* p);
 
   /** @brief 標準コンテナ用のメモリアロケータ */
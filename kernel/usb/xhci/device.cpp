@@ -1,6 +1,7 @@
 #include "usb/xhci/device.hpp"
 
 #include "logger.hpp"
+#include "trace.hpp"
 #include "usb/memory.hpp"
 #include "usb/xhci/ring.hpp"
 
@@ -27,51 +28,45 @@ namespace {
     return data;
   }
 
-  void Log(LogLevel level, const DataStageTRB& trb) {
-    Log(level,
-        "DataStageTRB: len %d, buf 0x%08lx, dir %d, attr 0x%02x\n",
-        trb.bits.trb_transfer_length,
-        trb.bits.data_buffer_pointer,
-        trb.bits.direction,
-        trb.data[3] & 0x7fu);
+  void Trace(const DataStageTRB& trb) {
+    TRACE(XHCIDataStageTRB,
+          trb.bits.trb_transfer_length,
+          trb.bits.data_buffer_pointer,
+          trb.bits.direction,
+          trb.data[3] & 0x7fu);
   }
 
-  void Log(LogLevel level, const SetupStageTRB& trb) {
-    Log(level,
-        "  SetupStage TRB: req_type %02x, req %02x, val %02x, ind %02x, len %02x\n",
-        trb.bits.request_type,
-        trb.bits.request,
-        trb.bits.value,
-        trb.bits.index,
-        trb.bits.length);
+  void Trace(const SetupStageTRB& trb) {
+    TRACE(XHCISetupStageTRB,
+          trb.bits.request_type,
+          trb.bits.request,
+          trb.bits.value,
+          trb.bits.index,
+          trb.bits.length);
   }
 
-  void Log(LogLevel level, const TransferEventTRB& trb) {
+  void Trace(const TransferEventTRB& trb) {
     if (trb.bits.event_data) {
-      Log(level,
-          "Transfer (value %08lx) completed: %s, residual length %d, slot %d, ep addr %d\n",
-          reinterpret_cast<uint64_t>(trb.Pointer()),
-          kTRBCompletionCodeToName[trb.bits.completion_code],
-          trb.bits.trb_transfer_length,
-          trb.bits.slot_id,
-          trb.EndpointID().Address());
+      TRACE(XHCITransferEventData,
+            trb.Pointer(),
+            trb.bits.completion_code,
+            trb.bits.trb_transfer_length,
+            trb.bits.slot_id,
+            trb.EndpointID().Address());
       return;
     }
 
     TRB* issuer_trb = trb.Pointer();
-    Log(level,
-        "%s completed: %s, residual length %d, slot %d, ep addr %d\n",
-        kTRBTypeToName[issuer_trb->bits.trb_type],
-        kTRBCompletionCodeToName[trb.bits.completion_code],
-        trb.bits.trb_transfer_length,
-        trb.bits.slot_id,
-        trb.EndpointID().Address());
+    TRACE(XHCITransferEvent,
+          issuer_trb->bits.trb_type,
+          trb.bits.completion_code,
+          trb.bits.trb_transfer_length,
+          trb.bits.slot_id,
+          trb.EndpointID().Address());
     if (auto data_trb = TRBDynamicCast<DataStageTRB>(issuer_trb)) {
-      Log(level, "  ");
-      Log(level, *data_trb);
+      Trace(*data_trb);
     } else if (auto setup_trb = TRBDynamicCast<SetupStageTRB>(issuer_trb)) {
-      Log(level, "  ");
-      Log(level, *setup_trb);
+      Trace(*setup_trb);
     }
   }
 }
@@ -81,6 +76,15 @@ namespace usb::xhci {
       : slot_id_{slot_id}, dbreg_{dbreg} {
   }
 
+  Device::~Device() {
+    for (auto tr : transfer_rings_) {
+      if (tr) {
+        tr->~Ring();
+        FreeMem(tr);
+      }
+    }
+  }
+
   Error Device::Initialize() {
     state_ = State::kBlank;
     for (size_t i = 0; i < 31; ++i) {
@@ -96,6 +100,10 @@ namespace usb::xhci {
 
   Ring* Device::AllocTransferRing(DeviceContextIndex index, size_t buf_size) {
     int i = index.value - 1;
+    if (auto old_tr = transfer_rings_[i]) {
+      old_tr->~Ring();
+      FreeMem(old_tr);
+    }
     auto tr = AllocArray<Ring>(1, 64, 4096);
     if (tr) {
       tr->Initialize(buf_size);
@@ -110,7 +118,7 @@ namespace usb::xhci {
       return err;
     }
 
-    Log(kDebug, "Device::ControlIn: ep addr %d, buf 0x%08x, len %d\n",
+    Log(kDebug, "Device::ControlIn: ep addr %d, buf %p, len %d\n",
         ep_id.Address(), buf, len);
     if (ep_id.Number() < 0 || 15 < ep_id.Number()) {
       return MAKE_ERROR(Error::kInvalidEndpointNumber);
@@ -157,7 +165,7 @@ namespace usb::xhci {
       return err;
     }
 
-    Log(kDebug, "Device::ControlOut: ep addr %d, buf 0x%08x, len %d\n",
+    Log(kDebug, "Device::ControlOut: ep addr %d, buf %p, len %d\n",
         ep_id.Address(), buf, len);
     if (ep_id.Number() < 0 || 15 < ep_id.Number()) {
       return MAKE_ERROR(Error::kInvalidEndpointNumber);
@@ -227,7 +235,7 @@ namespace usb::xhci {
       return err;
     }
 
-    Log(kDebug, "Device::InterrutpOut: ep addr %d, buf %08lx, len %d, dev %08lx\n",
+    Log(kDebug, "Device::InterrutpOut: ep addr %d, buf %p, len %d, dev %p\n",
         ep_id.Address(), buf, len, this);
     return MAKE_ERROR(Error::kNotImplemented);
   }
@@ -237,10 +245,10 @@ namespace usb::xhci {
 
     if (trb.bits.completion_code != 1 /* Success */ &&
         trb.bits.completion_code != 13 /* Short Packet */) {
-      Log(kDebug, trb);
+      Trace(trb);
       return MAKE_ERROR(Error::kTransferFailed);
     }
-    Log(kDebug, trb);
+    Trace(trb);
 
     TRB* issuer_trb = trb.Pointer();
     if (auto normal_trb = TRBDynamicCast<NormalTRB>(issuer_trb)) {
@@ -255,7 +263,7 @@ namespace usb::xhci {
       Log(kDebug, "No Corresponding Setup Stage for issuer %s\n",
           kTRBTypeToName[issuer_trb->bits.trb_type]);
       if (auto data_trb = TRBDynamicCast<DataStageTRB>(issuer_trb)) {
-        Log(kDebug, *data_trb);
+        Trace(*data_trb);
       }
       return MAKE_ERROR(Error::kNoCorrespondingSetupStage);
     }
@@ -34,6 +34,8 @@ namespace usb::xhci {
         TRB* issue_trb);
 
     Device(uint8_t slot_id, DoorbellRegister* dbreg);
+    /** @brief 確保した転送リングを解放する */
+    ~Device() override;
 
     Error Initialize();
 
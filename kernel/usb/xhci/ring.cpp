@@ -22,7 +22,6 @@ namespace usb::xhci {
     if (buf_ == nullptr) {
       return MAKE_ERROR(Error::kNoEnoughMemory);
     }
-    memset(buf_, 0, buf_size_ * sizeof(TRB));
 
     return MAKE_ERROR(Error::kSuccess);
   }
@@ -67,14 +66,12 @@ namespace usb::xhci {
     if (buf_ == nullptr) {
       return MAKE_ERROR(Error::kNoEnoughMemory);
     }
-    memset(buf_, 0, buf_size_ * sizeof(TRB));
 
     erst_ = AllocArray<EventRingSegmentTableEntry>(1, 64, 64 * 1024);
     if (erst_ == nullptr) {
       FreeMem(buf_);
       return MAKE_ERROR(Error::kNoEnoughMemory);
     }
-    memset(erst_, 0, 1 * sizeof(EventRingSegmentTableEntry));
 
     erst_[0].bits.ring_segment_base_address = reinterpret_cast<uint64_t>(buf_);
     erst_[0].bits.ring_segment_size = buf_size_;
@@ -2,8 +2,11 @@
 
 #include <cstring>
 #include "logger.hpp"
+#include "memstat.hpp"
+#include "trace.hpp"
 #include "pci.hpp"
 #include "interrupt.hpp"
+#include "paging.hpp"
 #include "usb/setupdata.hpp"
 #include "usb/device.hpp"
 #include "usb/descriptor.hpp"
@@ -12,6 +15,9 @@
 namespace {
     using namespace usb::xhci;
 
+    /** @brief 아이덴티티 매핑할 xHC 레지스터 영역의 크기 */
+    const uint64_t kMMIOSize = 64 * 1024;
+
     Error RegisterCommandRing(Ring* ring, MemMapRegister<CRCR_Bitmap>* crcr) {
         CRCR_Bitmap value = crcr->Read();
         value.bits.ring_cycle_state = true;
@@ -195,7 +201,7 @@ namespace {
     }
 
     Error OnEvent(Controller& xhc, PortStatusChangeEventTRB& trb) {
-        Log(kDebug, "PortStatusChangeEvent: port_id = %d\n", trb.bits.port_id);
+        TRACE(XHCIPortStatusChange, trb.bits.port_id);
         auto port_id = trb.bits.port_id;
         auto port = xhc.PortAt(port_id);
 
@@ -230,8 +236,7 @@ namespace {
     Error OnEvent(Controller& xhc, CommandCompletionEventTRB& trb) {
         const auto issuer_type = trb.Pointer()->bits.trb_type;
         const auto slot_id = trb.bits.slot_id;
-        Log(kDebug, "CommandCompletionEvent: slot_id = %d, issuer = %s\n",
-            trb.bits.slot_id, kTRBTypeToName[issuer_type]);
+        TRACE(XHCICommandCompletion, slot_id, issuer_type, trb.bits.completion_code);
 
         if (issuer_type == EnableSlotCommandTRB::Type) {
             if (port_config_phase[addressing_port] != ConfigPhase::kEnablingSlot) {
@@ -329,7 +334,7 @@ namespace {
         pci::WriteConfReg(xhc_dev, 0xd8, superspeed_ports); // USB3_PSSEN
         uint32_t ehci2xhci_ports = pci::ReadConfReg(xhc_dev, 0xd4); // XUSB2PRM
         pci::WriteConfReg(xhc_dev, 0xd0, ehci2xhci_ports); // XUSB2PR
-        Log(kDebug, "SwitchEhci2Xhci: SS = %02, xHCI = %02x\n",
+        Log(kDebug, "SwitchEhci2Xhci: SS = %02x, xHCI = %02x\n",
             superspeed_ports, ehci2xhci_ports);
     }
 } // namespace
@@ -531,6 +536,8 @@ namespace usb::xhci {
     Controller* controller;
 
     void Initialize() {
+        HeapCategoryScope heap_category{HeapCategory::kUSB};
+
         // Intel 製を優先して xHC を探す
         pci::Device* xhc_dev = nullptr;
         for (int i = 0; i < pci::num_device; ++i) {
@@ -562,6 +569,11 @@ namespace usb::xhci {
         Log(kDebug, "ReadBar: %s\n", xhc_bar.error.Name());
         const uint64_t xhc_mmio_base = xhc_bar.value & ~static_cast<uint64_t>(0xf);
         Log(kDebug, "xHC mmio_base = %08lx\n", xhc_mmio_base);
+        // 64비트 BAR는 4GiB 위에 배치될 수 있어 아이덴티티 매핑에 포함되지 않을 수 있다
+        if (auto err = MapIdentity(xhc_mmio_base, kMMIOSize)) {
+            Log(kError, "failed to map xHC mmio: %s\n", err.Name());
+            exit(1);
+        }
 
         usb::xhci::controller = new Controller{xhc_mmio_base};
         Controller& xhc = *usb::xhci::controller;
@@ -592,6 +604,7 @@ namespace usb::xhci {
     }
 
     void ProcessEvents() {
+        HeapCategoryScope heap_category{HeapCategory::kUSB};
         while (controller->PrimaryEventRing()->HasFront()) {
             if (auto err = ProcessEvent(*controller)) {
                 Log(kError, "Error while ProcessEvent: %s at %s:%d\n",
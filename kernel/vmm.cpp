@@ -0,0 +1,134 @@
+#include "vmm.hpp"
+
+#include <array>
+
+#include "interrupt.hpp"
+#include "logger.hpp"
+#include "memory_manager.hpp"
+#include "paging.hpp"
+#include "zero_pool.hpp"
+
+namespace {
+    const uint64_t kPageSize = 4096;
+    /** @brief 동시에 예약할 수 있는 영역의 최대 수 */
+    const size_t kMaxVirtualAreas = 256;
+
+    /** @brief 페이지 폴트 에러 코드: 보호 위반(페이지는 존재함) */
+    const uint64_t kPageFaultPresent = 1;
+    /** @brief 페이지 폴트 에러 코드: 쓰기 접근 */
+    const uint64_t kPageFaultWrite = 2;
+
+    /** @brief 예약된 가상 영역 [begin, end). end 뒤 한 페이지는 가드 페이지 */
+    struct VirtualArea {
+        uint64_t begin, end;
+    };
+
+    /** @brief begin 오름차순으로 정렬된 예약 영역 */
+    std::array<VirtualArea, kMaxVirtualAreas> areas;
+    size_t num_areas;
+    size_t mapped_pages;
+    /** @brief 읽기 폴트에 읽기 전용으로 공유해 매핑하는 0 페이지의 물리 주소. 0이면 아직 할당하지 않음 */
+    uint64_t zero_page;
+
+    /** @brief addr을 포함하는 영역의 인덱스. 없으면 num_areas */
+    size_t FindArea(uint64_t addr) {
+        for (size_t i = 0; i < num_areas; ++i) {
+            if (areas[i].begin <= addr && addr < areas[i].end) {
+                return i;
+            }
+        }
+        return num_areas;
+    }
+}
+
+WithError<void*> AllocateVirtual(size_t bytes) {
+    const uint64_t size = (bytes + kPageSize - 1) & ~(kPageSize - 1);
+
+    InterruptGuard guard;
+    if (size == 0 || num_areas == kMaxVirtualAreas) {
+        return {nullptr, MAKE_ERROR(Error::kNoEnoughMemory)};
+    }
+
+    // 영역 사이의 빈 구간을 앞에서부터 찾는다(first fit)
+    uint64_t begin = kKernelVirtualBase;
+    size_t index = 0;
+    for (; index < num_areas; ++index) {
+        if (begin + size + kPageSize <= areas[index].begin) {
+            break;
+        }
+        begin = areas[index].end + kPageSize;
+    }
+    if (begin + size + kPageSize > kKernelVirtualBase + kKernelVirtualSize) {
+        return {nullptr, MAKE_ERROR(Error::kNoEnoughMemory)};
+    }
+
+    for (size_t i = num_areas; i > index; --i) {
+        areas[i] = areas[i - 1];
+    }
+    areas[index] = {begin, begin + size};
+    ++num_areas;
+    return {reinterpret_cast<void*>(begin), MAKE_ERROR(Error::kSuccess)};
+}
+
+void FreeVirtual(void* addr) {
+    if (addr == nullptr) {
+        return;
+    }
+
+    InterruptGuard guard;
+    const size_t index = FindArea(reinterpret_cast<uint64_t>(addr));
+    if (index == num_areas || areas[index].begin != reinterpret_cast<uint64_t>(addr)) {
+        Log(kError, "FreeVirtual: %p is not an allocated area\n", addr);
+        return;
+    }
+
+    for (uint64_t page = areas[index].begin; page < areas[index].end; page += kPageSize) {
+        if (const uint64_t frame = UnmapPage(page); frame != 0 && frame != zero_page) {
+            FreeFrames(FrameID{frame / kBytesPerFrame}, 1, FrameOwner::kVirtual);
+            --mapped_pages;
+        }
+    }
+
+    --num_areas;
+    for (size_t i = index; i < num_areas; ++i) {
+        areas[i] = areas[i + 1];
+    }
+}
+
+bool HandlePageFault(uint64_t addr, uint64_t error_code) {
+    if (FindArea(addr) == num_areas) {
+        return false;
+    }
+    const uint64_t page = addr & ~(kPageSize - 1);
+
+    if ((error_code & kPageFaultWrite) == 0) {
+        if (error_code & kPageFaultPresent) {
+            return false;
+        }
+        // 읽기만 하는 동안은 프레임을 쓰지 않도록 공유 0 페이지를 읽기 전용으로 매핑한다
+        if (zero_page == 0) {
+            const auto frame = AllocateFrames(1, FrameOwner::kVirtual, true);
+            if (frame.error) {
+                return false;
+            }
+            zero_page = reinterpret_cast<uint64_t>(frame.value.Frame());
+        }
+        return !MapPage(page, zero_page, false);
+    }
+
+    // 쓰기 폴트: 미매핑 페이지이거나, 영역 안에서 읽기 전용인 페이지는 공유 0 페이지뿐이다
+    const auto frame = AllocateFrames(1, FrameOwner::kVirtual, true);
+    if (frame.error) {
+        return false;
+    }
+    if (MapPage(page, reinterpret_cast<uint64_t>(frame.value.Frame()))) {
+        FreeFrames(frame.value, 1, FrameOwner::kVirtual);
+        return false;
+    }
+    ++mapped_pages;
+    return true;
+}
+
+size_t CountMappedVirtualPages() {
+    return mapped_pages;
+}
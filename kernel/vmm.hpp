@@ -0,0 +1,46 @@
+/**
+ * @file vmm.hpp
+ *
+ * 커널 가상 영역을 4KiB 페이지 단위로 관리하는 가상 메모리 관리자.
+ * 예약한 영역은 처음 접근할 때 페이지 폴트 핸들러가 매핑한다(demand-zero).
+ * 읽기만 한 페이지는 공유 0 페이지를 읽기 전용으로 가리키고, 처음 쓸 때 0으로 채운 전용 프레임으로 바꾼다.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "error.hpp"
+
+/** @brief 커널 가상 영역의 시작 주소. 상위 절반(PML4 256번)이며 아이덴티티 매핑과 겹치지 않는다. */
+const uint64_t kKernelVirtualBase = 0xffff800000000000;
+/** @brief 커널 가상 영역의 크기(64GiB) */
+const uint64_t kKernelVirtualSize = uint64_t{64} << 30;
+
+/** @brief 커널 가상 영역에서 bytes 바이트를 예약합니다.
+ * 물리 프레임은 페이지에 처음 쓸 때 할당되어 0으로 채워집니다. 그 전에는 0으로 읽힙니다.
+ * 영역 뒤에는 매핑하지 않는 가드 페이지를 하나 둡니다.
+ *
+ * @return 예약한 영역의 선두 주소(4KiB 정렬)
+ */
+WithError<void*> AllocateVirtual(size_t bytes);
+
+/** @brief AllocateVirtual로 예약한 영역을 해제하고 매핑된 프레임을 돌려줍니다. */
+void FreeVirtual(void* addr);
+
+/** @brief 페이지 폴트를 처리합니다. 예약된 영역의 페이지면
+ * 읽기 폴트에는 공유 0 페이지를, 쓰기 폴트에는 0으로 채운 전용 프레임을 매핑합니다.
+ * @param addr 폴트 주소(CR2)
+ * @param error_code CPU가 전달한 에러 코드
+ * @return 처리했으면 true. false면 복구할 수 없는 폴트
+ */
+bool HandlePageFault(uint64_t addr, uint64_t error_code);
+
+/** @brief 현재 전용 프레임이 매핑된 커널 가상 페이지 수. 공유 0 페이지를 가리키는 페이지는 세지 않는다. */
+size_t CountMappedVirtualPages();
+
+/** @brief unique_ptr에서 AllocateVirtual로 예약한 영역을 해제하는 삭제자 */
+struct VirtualMemoryDeleter {
+    void operator()(void* addr) const { FreeVirtual(addr); }
+};
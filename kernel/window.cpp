@@ -5,29 +5,71 @@
 #include "font.hpp"
 
 Window::Window(int width, int height, PixelFormat shadow_format)
-    : width_{width}, height_{height} {
-    data_.resize(height);
-    for (int y = 0; y < height; ++y) {
-        data_[y].resize(width);
+    : width_{width}, height_{height}, shadow_format_{shadow_format} {
+    AllocateSurface();
+}
+
+void Window::AllocateSurface() {
+    data_.resize(height_);
+    for (int y = 0; y < height_; ++y) {
+        data_[y].resize(width_);
     }
 
     FrameBufferConfig config{};
     config.frame_buffer = nullptr;
-    config.horizontal_resolution = width;
-    config.vertical_resolution = height;
-    config.pixel_format = shadow_format;
+    config.horizontal_resolution = width_;
+    config.vertical_resolution = height_;
+    config.pixel_format = shadow_format_;
 
     if (auto err = shadow_buffer_.Initialize(config)) {
         Log(kError, "failed to initialize shadow buffer: %s at %s:%d\n",
             err.Name(), err.File(), err.Line());
     }
+    has_surface_ = true;
+}
+
+void Window::SetRedrawCallback(RedrawCallback callback) {
+    redraw_ = callback;
+}
+
+size_t Window::ReleaseSurface() {
+    if (!redraw_ || !has_surface_) {
+        return 0;
+    }
+
+    const size_t bytes = SurfaceBytes();
+    has_surface_ = false;
+    std::vector<std::vector<PixelColor>>{}.swap(data_);
+    shadow_buffer_ = FrameBuffer{};
+    return bytes;
+}
+
+void Window::RestoreSurface() {
+    if (has_surface_) {
+        return;
+    }
+    AllocateSurface();
+    redraw_(*this);
 }
 
 Vector2D<int> Window::Size() {
     return {width_, height_};
 }
 
+size_t Window::SurfaceBytes() const {
+    if (!has_surface_) {
+        return 0;
+    }
+    const size_t pixels = static_cast<size_t>(width_) * height_;
+    return pixels * sizeof(PixelColor) +
+        pixels * BitsPerPixel(shadow_buffer_.Config().pixel_format) / 8;
+}
+
 void Window::DrawTo(FrameBuffer &dst, Vector2D<int> position, const Rectangle<int>& area) {
+    if (!has_surface_) {
+        return;
+    }
+
     if (!transparent_color_) {
         Rectangle<int> window_area{position, this->Size()};
         Rectangle<int> intersection = area & window_area;
@@ -56,6 +98,9 @@ void Window::SetTransparentColor(std::optional<PixelColor> c) {
 Window::WindowWriter *Window::Writer() { return &writer_; }
 
 void Window::Write(Vector2D<int> pos, PixelColor c) {
+    if (!has_surface_) {
+        return;
+    }
     data_[pos.y][pos.x] = c;
     shadow_buffer_.Writer().Write(pos, c);
 }
@@ -69,6 +114,9 @@ int Window::Width() const { return width_; }
 int Window::Height() const { return height_; }
 
 void Window::Move(Vector2D<int> dst_pos, const Rectangle<int> &src) {
+    if (!has_surface_) {
+        return;
+    }
     shadow_buffer_.Move(dst_pos, src);
 }
 
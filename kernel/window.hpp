@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <optional>
 #include <vector>
 
@@ -76,6 +77,21 @@ class Window {
      */
     Vector2D<int> Size();
 
+    /** @brief 픽셀 배열과 그림자 버퍼가 차지하는 바이트 수. 해제되어 있으면 0 */
+    size_t SurfaceBytes() const;
+
+    /** @brief 표면을 다시 할당한 뒤 내용을 그리는 콜백 */
+    using RedrawCallback = std::function<void (Window& window)>;
+    /** @brief 재묘화 콜백을 설정합니다. 콜백이 있는 윈도우만 메모리 부족 시 표면을 해제할 수 있습니다. */
+    void SetRedrawCallback(RedrawCallback callback);
+    /** @brief 픽셀 배열과 그림자 버퍼를 해제합니다. 해제되어 있는 동안의 쓰기는 버려집니다.
+     * @return 해제한 바이트 수. 재묘화 콜백이 없거나 이미 해제되어 있으면 0
+     */
+    size_t ReleaseSurface();
+    /** @brief 표면이 해제되어 있으면 다시 할당하고 재묘화 콜백으로 내용을 그립니다. */
+    void RestoreSurface();
+    bool HasSurface() const { return has_surface_; }
+
   private:
     int width_, height_;
     std::vector<std::vector<PixelColor>> data_{};
@@ -83,6 +99,11 @@ class Window {
     std::optional<PixelColor> transparent_color_{std::nullopt};
 
     FrameBuffer shadow_buffer_{};
+    PixelFormat shadow_format_;
+    bool has_surface_{false};
+    RedrawCallback redraw_{};
+
+    void AllocateSurface();
 };
 
 void DrawWindow(PixelWriter& writer, const char* title);
\ No newline at end of file
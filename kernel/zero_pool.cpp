@@ -0,0 +1,154 @@
+#include "zero_pool.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "interrupt.hpp"
+
+namespace {
+    /** @brief 0으로 채운 프레임 ID의 스택. 인터럽트 핸들러와 공유하므로 InterruptGuard 안에서 조작한다 */
+    std::array<size_t, kZeroPoolFrames> zero_pool;
+    size_t zero_pool_count;
+    /** @brief 풀에 있는 프레임 중 kDMA32 존의 프레임 수 */
+    size_t zero_pool_dma32;
+
+    /** @brief 풀의 index 번째 프레임을 꺼냅니다. 빈 자리는 맨 위 프레임으로 메웁니다. InterruptGuard 안에서 호출합니다. */
+    FrameID TakeZeroPool(size_t index) {
+        const FrameID frame{zero_pool[index]};
+        zero_pool[index] = zero_pool[--zero_pool_count];
+        if (ZoneOf(frame) == MemoryZone::kDMA32) {
+            --zero_pool_dma32;
+        }
+        return frame;
+    }
+
+    /** @brief 풀에서 프레임을 하나 꺼냅니다. zone을 주면 그 존의 프레임만 꺼냅니다. */
+    WithError<FrameID> PopZeroPool(const MemoryZone* zone = nullptr) {
+        InterruptGuard guard;
+        for (size_t i = zero_pool_count; i > 0; --i) {
+            if (zone == nullptr || ZoneOf(FrameID{zero_pool[i - 1]}) == *zone) {
+                return {TakeZeroPool(i - 1), MAKE_ERROR(Error::kSuccess)};
+            }
+        }
+        return {kNullFrame, MAKE_ERROR(Error::kEmpty)};
+    }
+}
+
+void ZeroNonTemporal(void* p, size_t bytes) {
+    auto q = reinterpret_cast<uint64_t*>(p);
+    auto end = q + bytes / sizeof(uint64_t);
+    for (; q + 4 <= end; q += 4) {
+        __asm__ volatile(
+            "movnti %1, 0(%0)\n\t"
+            "movnti %1, 8(%0)\n\t"
+            "movnti %1, 16(%0)\n\t"
+            "movnti %1, 24(%0)"
+            : : "r"(q), "r"(uint64_t{0}) : "memory");
+    }
+    for (; q < end; ++q) {
+        __asm__ volatile("movnti %1, (%0)" : : "r"(q), "r"(uint64_t{0}) : "memory");
+    }
+    // non-temporal 저장은 약한 순서를 따르므로 이후의 저장보다 먼저 보이도록 한다
+    __asm__ volatile("sfence" : : : "memory");
+}
+
+WithError<FrameID> AllocateFrames(size_t num_frames, FrameOwner owner, bool zeroed) {
+    if (zeroed && num_frames == 1) {
+        if (auto frame = PopZeroPool(); !frame.error) {
+            AccountFrames(FrameOwner::kZeroPool, -1);
+            AccountFrames(owner, 1);
+            return frame;
+        }
+    }
+
+    WithError<FrameID> frame{kNullFrame, MAKE_ERROR(Error::kSuccess)};
+    {
+        InterruptGuard guard;
+        frame = memory_manager->Allocate(num_frames);
+    }
+    if (frame.error) {
+        return frame;
+    }
+    AccountFrames(owner, num_frames);
+    if (zeroed) {
+        ZeroNonTemporal(frame.value.Frame(), num_frames * kBytesPerFrame);
+    }
+    return frame;
+}
+
+WithError<FrameID> AllocateFrames(size_t num_frames, MemoryZone zone, size_t alignment,
+                                  FrameOwner owner, bool zeroed) {
+    if (zeroed && num_frames == 1 && alignment <= 1) {
+        if (auto frame = PopZeroPool(&zone); !frame.error) {
+            AccountFrames(FrameOwner::kZeroPool, -1);
+            AccountFrames(owner, 1);
+            return frame;
+        }
+    }
+
+    WithError<FrameID> frame{kNullFrame, MAKE_ERROR(Error::kSuccess)};
+    {
+        InterruptGuard guard;
+        frame = memory_manager->Allocate(num_frames, zone, alignment);
+    }
+    if (frame.error) {
+        return frame;
+    }
+    AccountFrames(owner, num_frames);
+    if (zeroed) {
+        ZeroNonTemporal(frame.value.Frame(), num_frames * kBytesPerFrame);
+    }
+    return frame;
+}
+
+void FreeFrames(FrameID frame, size_t num_frames, FrameOwner owner) {
+    InterruptGuard guard;
+    memory_manager->Free(frame, num_frames);
+    AccountFrames(owner, -static_cast<long>(num_frames));
+}
+
+size_t DrainZeroPool(size_t max_frames) {
+    InterruptGuard guard;
+    size_t frames = 0;
+    for (; frames < max_frames && zero_pool_count > 0; ++frames) {
+        memory_manager->Free(TakeZeroPool(zero_pool_count - 1), 1);
+    }
+    AccountFrames(FrameOwner::kZeroPool, -static_cast<long>(frames));
+    return frames;
+}
+
+bool ZeroPoolNeedsRefill() {
+    return zero_pool_count < kZeroPoolFrames;
+}
+
+void RefillZeroPool(size_t max_frames) {
+    for (size_t i = 0; i < max_frames && ZeroPoolNeedsRefill(); ++i) {
+        WithError<FrameID> frame{kNullFrame, MAKE_ERROR(Error::kSuccess)};
+        {
+            InterruptGuard guard;
+            // DMA32 프레임을 일정량 먼저 채워 두어 DMA 버퍼도 풀에서 받을 수 있게 한다
+            if (zero_pool_dma32 < kZeroPoolDMA32Frames) {
+                frame = memory_manager->Allocate(1, MemoryZone::kDMA32, 1);
+            }
+            if (zero_pool_dma32 >= kZeroPoolDMA32Frames || frame.error) {
+                frame = memory_manager->Allocate(1);
+            }
+        }
+        if (frame.error) {
+            return;
+        }
+
+        ZeroNonTemporal(frame.value.Frame(), kBytesPerFrame);
+
+        InterruptGuard guard;
+        if (zero_pool_count == kZeroPoolFrames) {
+            memory_manager->Free(frame.value, 1);
+            return;
+        }
+        zero_pool[zero_pool_count++] = frame.value.ID();
+        if (ZoneOf(frame.value) == MemoryZone::kDMA32) {
+            ++zero_pool_dma32;
+        }
+        AccountFrames(FrameOwner::kZeroPool, 1);
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * @file zero_pool.hpp
+ *
+ * 메인 루프의 유휴 시간에 미리 0으로 채워 두는 프레임 풀.
+ * 0으로 채우는 작업은 non-temporal 저장(movnti)으로 하여 캐시를 오염시키지 않는다.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "error.hpp"
+#include "memory_manager.hpp"
+#include "memstat.hpp"
+
+/** @brief 풀에 보관하는 0으로 채운 프레임의 최대 수(1MiB) */
+const size_t kZeroPoolFrames = 256;
+/** @brief 풀이 먼저 채워 두는 kDMA32 존 프레임의 수. USB 링과 컨텍스트처럼 4GiB 미만이어야 하는 버퍼용 */
+const size_t kZeroPoolDMA32Frames = 32;
+/** @brief 메인 루프가 유휴 시간에 한 번에 채우는 프레임 수 */
+const size_t kIdleZeroFrames = 8;
+
+/** @brief memory_manager에서 프레임을 할당하고 owner의 몫으로 집계합니다.
+ * zeroed면 0으로 채운 프레임을 돌려줍니다. 1프레임 요청은 풀에서 꺼내고,
+ * 풀이 비었거나 여러 프레임이면 non-temporal 저장으로 그 자리에서 채웁니다.
+ */
+WithError<FrameID> AllocateFrames(size_t num_frames, FrameOwner owner, bool zeroed = false);
+
+/** @brief zone에서 alignment 프레임 경계에 맞춰 할당합니다.
+ * zeroed면 정렬 제약이 없는 1프레임 요청은 풀에 있는 그 존의 프레임을 꺼내고,
+ * 그 밖에는 non-temporal 저장으로 그 자리에서 채웁니다.
+ */
+WithError<FrameID> AllocateFrames(size_t num_frames, MemoryZone zone, size_t alignment,
+                                  FrameOwner owner, bool zeroed = false);
+
+/** @brief AllocateFrames로 할당한 프레임을 돌려줍니다. */
+void FreeFrames(FrameID frame, size_t num_frames, FrameOwner owner);
+
+/** @brief bytes 바이트(8의 배수)를 non-temporal 저장으로 0으로 채웁니다. */
+void ZeroNonTemporal(void* p, size_t bytes);
+
+/** @brief 풀의 프레임을 최대 max_frames 개 memory_manager에 돌려줍니다. 메모리 회수 시 호출합니다.
+ * @return 돌려준 프레임 수
+ */
+size_t DrainZeroPool(size_t max_frames);
+
+/** @brief 풀에 빈 자리가 있는지 여부. 메인 루프가 hlt 전에 확인합니다. */
+bool ZeroPoolNeedsRefill();
+
+/** @brief 프레임을 최대 max_frames 개 0으로 채워 풀에 넣습니다.
+ * 인터럽트를 허가한 채 호출합니다. 도중에 도착한 메시지는 돌아온 뒤에 처리되므로 max_frames는 작게 유지합니다.
+ */
+void RefillZeroPool(size_t max_frames);
@@ -0,0 +1,112 @@
+#!/usr/bin/python3
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+
+MAGIC = b'MIKTRACE'
+HEADER_FORMAT = '<8sIIIIQ'
+RECORD_FORMAT = '<QHBBI6Q'
+EVENT_PATTERN = re.compile(r'^\s*TRACE_EVENT\(\s*(\w+)\s*((?:,\s*[\w:]+\s*)*)\)')
+
+
+def load_events(path: str) -> list:
+    events = []
+    with open(path) as f:
+        for line in f:
+            m = EVENT_PATTERN.match(line)
+            if not m:
+                continue
+            args = [a.strip() for a in m.group(2).split(',') if a.strip()]
+            events.append((m.group(1), [a.split(':') for a in args]))
+    return events
+
+
+def to_signed(value: int) -> int:
+    return value - (1 << 64) if value & (1 << 63) else value
+
+
+def decode(dump: bytes, events: list, tsc_mhz: float) -> dict:
+    pos = dump.find(MAGIC)
+    if pos < 0:
+        raise ValueError('trace header not found')
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    (_, version, record_size, num_cpus, records_per_cpu,
+     tsc_hz) = struct.unpack_from(HEADER_FORMAT, dump, pos)
+    if version not in (1, 2) or record_size != struct.calcsize(RECORD_FORMAT):
+        raise ValueError('unsupported trace version {} (record size {})'.format(
+            version, record_size))
+    if tsc_mhz is None:
+        tsc_mhz = tsc_hz / 1e6 if tsc_hz else 1.0
+    pos += header_size
+
+    records = []
+    for _ in range(num_cpus):
+        head, = struct.unpack_from('<Q', dump, pos)
+        pos += 8
+        count = min(head, records_per_cpu)
+        first = head - count
+        for i in range(first, head):
+            offset = pos + (i % records_per_cpu) * record_size
+            tsc, event_id, cpu, num_args, _, *args = struct.unpack_from(
+                RECORD_FORMAT, dump, offset)
+            records.append((tsc, event_id, cpu, args[:num_args]))
+        # version 1 sends every slot; version 2 sends only the valid ones
+        pos += (records_per_cpu if version == 1 else count) * record_size
+
+    records.sort()
+    base_tsc = records[0][0] if records else 0
+    trace_events = []
+    for tsc, event_id, cpu, args in records:
+        if event_id < len(events):
+            name, arg_specs = events[event_id]
+        else:
+            name, arg_specs = 'Unknown{}'.format(event_id), []
+
+        named_args = {}
+        for i, value in enumerate(args):
+            spec = arg_specs[i] if i < len(arg_specs) else ['arg{}'.format(i)]
+            signed = len(spec) > 1 and spec[1] == 's'
+            named_args[spec[0]] = to_signed(value) if signed else value
+
+        trace_events.append({
+            'name': name,
+            'ph': 'i',
+            's': 't',
+            'ts': (tsc - base_tsc) / tsc_mhz,
+            'pid': 0,
+            'tid': cpu,
+            'args': named_args,
+        })
+
+    return {'traceEvents': trace_events, 'displayTimeUnit': 'ns'}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='convert a MikanOS trace dump into Chrome trace JSON')
+    parser.add_argument('dump', help='path to a raw dump captured from the serial port')
+    parser.add_argument('-e', '--events', help='path to trace_events.def',
+                        default='kernel/trace_events.def')
+    parser.add_argument('--tsc-mhz', type=float,
+                        help='TSC frequency in MHz (default: value in the dump, or 1)')
+    parser.add_argument('-o', help='path to an output file', default='-')
+    ns = parser.parse_args()
+
+    with open(ns.dump, 'rb') as f:
+        dump = f.read()
+    result = decode(dump, load_events(ns.events), ns.tsc_mhz)
+
+    if ns.o == '-':
+        json.dump(result, sys.stdout, indent=1)
+    else:
+        with open(ns.o, 'w') as out:
+            json.dump(result, out, indent=1)
+
+
+if __name__ == '__main__':
+    main()